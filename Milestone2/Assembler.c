@@ -0,0 +1,379 @@
+#include "Assembler.h"
+#include "Simulator.h"
+#include "Memory.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_STATEMENT_TOKENS 8
+
+struct Token {
+    const char* text;
+    int length;
+};
+
+struct Statement {
+    struct Token label;  // length 0 when the line has no label
+    struct Token tokens[MAX_STATEMENT_TOKENS];
+    int tokenCount;
+    struct Token values; // rest of a .word line, scanned separately so the list has no length limit
+    int valueCount;
+};
+
+struct Symbol {
+    const char* name; // NULL for an empty slot
+    int length;
+    int address;
+    int line;
+};
+
+/* State of one assembly run, so programs can be assembled on several threads at once */
+struct Assembler {
+    struct Symbol* symbols;
+    unsigned int symbolMask;
+    unsigned int symbolCount;
+    int errorCount;
+};
+
+static void reportError(struct Assembler* assembler, int line, const char* message, const struct Token* token) {
+    if (token != NULL)
+        printf("line %d: error: %s '%.*s'\n", line, message, token->length, token->text);
+    else
+        printf("line %d: error: %s\n", line, message);
+    assembler->errorCount++;
+}
+
+int lookupMnemonic(const char* mnemonic, int length) {
+    char m[4];
+
+    if (length < 1 || length > 4) return -1;
+    for (int i = 0; i < length; i++) m[i] = (char)toupper((unsigned char)mnemonic[i]);
+
+    switch (length) {
+        case 1:
+            if (m[0] == 'J') return 7;
+            break;
+        case 2:
+            if (m[1] != 'W') break;
+            if (m[0] == 'L') return 10;
+            if (m[0] == 'S') return 11;
+            break;
+        case 3:
+            switch (m[0]) {
+                case 'A': if (m[1] == 'D' && m[2] == 'D') return 0; break;
+                case 'S':
+                    if (m[1] == 'U' && m[2] == 'B') return 1;
+                    if (m[1] == 'L' && m[2] == 'L') return 8;
+                    if (m[1] == 'R' && m[2] == 'L') return 9;
+                    break;
+                case 'B': if (m[1] == 'N' && m[2] == 'E') return 4; break;
+                case 'O': if (m[1] == 'R' && m[2] == 'I') return 6; break;
+            }
+            break;
+        case 4:
+            if (m[3] != 'I') break;
+            if (m[0] == 'M' && m[1] == 'U' && m[2] == 'L') return 2;
+            if (m[0] == 'A' && m[1] == 'D' && m[2] == 'D') return 3;
+            if (m[0] == 'A' && m[1] == 'N' && m[2] == 'D') return 5;
+            break;
+    }
+    return -1;
+}
+
+static bool tokenIs(const struct Token* token, const char* text) {
+    return (int)strlen(text) == token->length && strncmp(token->text, text, token->length) == 0;
+}
+
+/* Advances past separators to the next token, false at the end of the line or a comment */
+static bool nextToken(const char** cursor, const char* end, struct Token* token) {
+    while (*cursor < end && (isspace((unsigned char)**cursor) || **cursor == ',')) (*cursor)++;
+    if (*cursor == end || **cursor == '#' || **cursor == ';' || (**cursor == '/' && *cursor + 1 < end && (*cursor)[1] == '/'))
+        return false;
+
+    token->text = *cursor;
+    while (*cursor < end && !isspace((unsigned char)**cursor) && **cursor != ',' && **cursor != ':' && **cursor != '#' && **cursor != ';')
+        (*cursor)++;
+    token->length = (int)(*cursor - token->text);
+    return true;
+}
+
+/* Counts the values of a .word line, rejecting anything that looks like a label among them */
+static bool countValues(struct Assembler* assembler, const struct SourceLine* line, struct Statement* statement) {
+    const char* cursor = statement->values.text;
+    const char* end = cursor + statement->values.length;
+    struct Token value;
+
+    statement->valueCount = 0;
+    while (nextToken(&cursor, end, &value)) {
+        if (cursor < end && *cursor == ':') {
+            struct Token colon = { value.text, value.length + 1 };
+            reportError(assembler, line->number, "unexpected label", &colon);
+            return false;
+        }
+        statement->valueCount++;
+    }
+    return true;
+}
+
+/* Splits one line into an optional label and its tokens, dropping comments */
+static bool splitStatement(struct Assembler* assembler, const struct SourceLine* line, struct Statement* statement) {
+    const char* cursor = line->text;
+    const char* end = line->text + line->length;
+    struct Token token;
+
+    statement->label.length = 0;
+    statement->tokenCount = 0;
+    statement->valueCount = 0;
+
+    while (nextToken(&cursor, end, &token)) {
+        if (cursor < end && *cursor == ':') {
+            if (statement->tokenCount > 0 || statement->label.length > 0 || token.length == 0) {
+                struct Token colon = { token.text, token.length + 1 };
+                reportError(assembler, line->number, "unexpected label", &colon);
+                return false;
+            }
+            statement->label = token;
+            cursor++;
+            continue;
+        }
+
+        if (statement->tokenCount == MAX_STATEMENT_TOKENS) {
+            reportError(assembler, line->number, "too many operands", NULL);
+            return false;
+        }
+        statement->tokens[statement->tokenCount++] = token;
+
+        if (statement->tokenCount == 1 && tokenIs(&token, ".word")) {
+            statement->values.text = cursor;
+            statement->values.length = (int)(end - cursor);
+            return countValues(assembler, line, statement);
+        }
+    }
+    return true;
+}
+
+static unsigned int hashName(const char* name, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static struct Symbol* findSymbolSlot(struct Assembler* assembler, const char* name, int length) {
+    unsigned int slot = hashName(name, length) & assembler->symbolMask;
+    while (assembler->symbols[slot].name != NULL &&
+           (assembler->symbols[slot].length != length || strncmp(assembler->symbols[slot].name, name, length) != 0))
+        slot = (slot + 1) & assembler->symbolMask;
+    return &assembler->symbols[slot];
+}
+
+/* Doubles the table, keeping it at most half full */
+static void growSymbols(struct Assembler* assembler) {
+    struct Symbol* oldSymbols = assembler->symbols;
+    unsigned int oldCapacity = assembler->symbolMask + 1;
+
+    assembler->symbols = calloc(oldCapacity * 2, sizeof(struct Symbol));
+    assembler->symbolMask = oldCapacity * 2 - 1;
+    for (unsigned int i = 0; i < oldCapacity; i++)
+        if (oldSymbols[i].name != NULL)
+            *findSymbolSlot(assembler, oldSymbols[i].name, oldSymbols[i].length) = oldSymbols[i];
+    free(oldSymbols);
+}
+
+static void defineSymbol(struct Assembler* assembler, const struct Token* label, int address, int line) {
+    if (2 * (assembler->symbolCount + 1) > assembler->symbolMask + 1)
+        growSymbols(assembler);
+
+    struct Symbol* symbol = findSymbolSlot(assembler, label->text, label->length);
+    if (symbol->name != NULL) {
+        char message[64];
+        sprintf(message, "label already defined on line %d:", symbol->line);
+        reportError(assembler, line, message, label);
+        return;
+    }
+    symbol->name = label->text;
+    symbol->length = label->length;
+    symbol->address = address;
+    symbol->line = line;
+    assembler->symbolCount++;
+}
+
+static bool parseNumber(const struct Token* token, long long* value) {
+    char text[32];
+    char* parseEnd;
+
+    if (token->length == 0 || token->length >= (int)sizeof(text)) return false;
+    memcpy(text, token->text, token->length);
+    text[token->length] = '\0';
+    *value = strtoll(text, &parseEnd, 0);
+    return *parseEnd == '\0';
+}
+
+/* A number, or a label standing for its address */
+static bool parseValue(struct Assembler* assembler, const struct Token* token, int line, long long* value) {
+    if (parseNumber(token, value)) return true;
+
+    if (isalpha((unsigned char)token->text[0]) || token->text[0] == '_' || token->text[0] == '.') {
+        struct Symbol* symbol = findSymbolSlot(assembler, token->text, token->length);
+        if (symbol->name != NULL) {
+            *value = symbol->address;
+            return true;
+        }
+        reportError(assembler, line, "undefined label", token);
+        return false;
+    }
+    reportError(assembler, line, "expected a number or label, got", token);
+    return false;
+}
+
+static bool parseRegister(struct Assembler* assembler, const struct Token* token, int line, int* reg) {
+    long long number;
+    struct Token digits = { token->text + 1, token->length - 1 };
+
+    if (token->length >= 2 && (token->text[0] == 'R' || token->text[0] == 'r') && isdigit((unsigned char)digits.text[0]) &&
+        parseNumber(&digits, &number) && number >= 0 && number < REGISTER_COUNT) {
+        *reg = (int)number;
+        return true;
+    }
+    reportError(assembler, line, "expected a register R0-R31, got", token);
+    return false;
+}
+
+static bool checkRange(struct Assembler* assembler, long long value, long long minimum, long long maximum, int line, const struct Token* token) {
+    if (value >= minimum && value <= maximum) return true;
+    reportError(assembler, line, "value out of range:", token);
+    return false;
+}
+
+static int encodeInstruction(struct Assembler* assembler, int opcode, const struct Statement* statement, int pc, int line) {
+    const struct Token* operands = statement->tokens + 1;
+    int operandCount = statement->tokenCount - 1;
+    int expected = opcode == 7 ? 1 : 3;
+    int binaryInstruction = opcode << 28;
+    int reg1 = 0, reg2 = 0, reg3 = 0;
+    long long value;
+
+    if (operandCount != expected) {
+        char message[64];
+        sprintf(message, "expected %d operand%s for", expected, expected == 1 ? "" : "s");
+        reportError(assembler, line, message, &statement->tokens[0]);
+        return 0;
+    }
+
+    if (opcode == 7) { //J
+        if (parseValue(assembler, &operands[0], line, &value) && checkRange(assembler, value, 0, 0xFFFFFFF, line, &operands[0]))
+            binaryInstruction |= (int)value;
+        return binaryInstruction;
+    }
+
+    if (!parseRegister(assembler, &operands[0], line, &reg1) || !parseRegister(assembler, &operands[1], line, &reg2))
+        return 0;
+    binaryInstruction |= reg1 << 23;
+    binaryInstruction |= reg2 << 18;
+
+    switch (opcode) {
+        case 0: //ADD
+        case 1: //SUB
+            if (parseRegister(assembler, &operands[2], line, &reg3))
+                binaryInstruction |= reg3 << 13;
+            break;
+        case 8: //SLL
+        case 9: //SRL
+            if (parseNumber(&operands[2], &value)) {
+                if (checkRange(assembler, value, 0, 0x1FFF, line, &operands[2]))
+                    binaryInstruction |= (int)value;
+            } else {
+                reportError(assembler, line, "expected a shift amount, got", &operands[2]);
+            }
+            break;
+        case 4: //BNE
+            // Numbers are offsets from the next instruction already, a label is converted to one
+            if (!parseNumber(&operands[2], &value)) {
+                if (!parseValue(assembler, &operands[2], line, &value)) break;
+                value -= pc + 1;
+            }
+            if (checkRange(assembler, value, -0x20000, 0x1FFFF, line, &operands[2]))
+                binaryInstruction |= (int)value & 0x3FFFF;
+            break;
+        default:
+            if (parseValue(assembler, &operands[2], line, &value) && checkRange(assembler, value, -0x20000, 0x1FFFF, line, &operands[2]))
+                binaryInstruction |= (int)value & 0x3FFFF;
+            break;
+    }
+    return binaryInstruction;
+}
+
+int assembleProgram(const struct SourceLine* lines, int lineCount, struct Memory* memory) {
+    struct Statement statement;
+    struct Assembler state = { calloc(64, sizeof(struct Symbol)), 63, 0, 0 };
+    struct Assembler* assembler = &state;
+    int dataOffset = memory->dataOffset;
+
+    // Pass 1: addresses of every label
+    int textCount = 0, dataCount = 0;
+    bool inData = false;
+    for (int i = 0; i < lineCount; i++) {
+        if (!splitStatement(assembler, &lines[i], &statement)) continue;
+
+        if (statement.label.length > 0)
+            defineSymbol(assembler, &statement.label, inData ? dataOffset + dataCount : textCount, lines[i].number);
+        if (statement.tokenCount == 0) continue;
+
+        if (tokenIs(&statement.tokens[0], ".data")) inData = true;
+        else if (tokenIs(&statement.tokens[0], ".text")) inData = false;
+        else if (tokenIs(&statement.tokens[0], ".word")) {
+            if (!inData) reportError(assembler, lines[i].number, ".word outside the .data section", NULL);
+            else dataCount += statement.valueCount;
+        } else if (inData) {
+            reportError(assembler, lines[i].number, "instruction inside the .data section:", &statement.tokens[0]);
+        } else {
+            if (lookupMnemonic(statement.tokens[0].text, statement.tokens[0].length) < 0)
+                reportError(assembler, lines[i].number, "unknown instruction", &statement.tokens[0]);
+            textCount++;
+        }
+    }
+
+    if (textCount > dataOffset)
+        reportError(assembler, lines[lineCount - 1].number, "program does not fit in the instruction region", NULL);
+    if (dataOffset + dataCount > memory->size)
+        reportError(assembler, lines[lineCount - 1].number, "data section does not fit in memory", NULL);
+
+    // Pass 2: encode, once the statements themselves are known to be well formed
+    if (assembler->errorCount == 0) {
+        int pc = 0, dataAddress = dataOffset;
+        for (int i = 0; i < lineCount; i++) {
+            if (!splitStatement(assembler, &lines[i], &statement) || statement.tokenCount == 0) continue;
+
+            const struct Token* first = &statement.tokens[0];
+            if (tokenIs(first, ".data") || tokenIs(first, ".text")) continue;
+
+            if (tokenIs(first, ".word")) {
+                const char* cursor = statement.values.text;
+                struct Token token;
+                while (nextToken(&cursor, statement.values.text + statement.values.length, &token)) {
+                    long long value;
+                    if (parseValue(assembler, &token, lines[i].number, &value) &&
+                        checkRange(assembler, value, INT32_MIN, UINT32_MAX, lines[i].number, &token))
+                        writeMemory(memory, dataAddress, (int)(uint32_t)value);
+                    dataAddress++;
+                }
+                continue;
+            }
+
+            writeMemory(memory, pc, encodeInstruction(assembler, lookupMnemonic(first->text, first->length), &statement, pc, lines[i].number));
+            pc++;
+        }
+    }
+
+    free(assembler->symbols);
+
+    if (assembler->errorCount > 0) {
+        printf("%d error%s, program not loaded\n", assembler->errorCount, assembler->errorCount == 1 ? "" : "s");
+        return -1;
+    }
+    return textCount;
+}
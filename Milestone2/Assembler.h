@@ -0,0 +1,21 @@
+#pragma once
+#include "Memory.h"
+#include <stdbool.h>
+
+struct SourceLine {
+    const char* text; // Points into the mapped program file, not null-terminated
+    int length;
+    int number;       // 1-based line number in the file, for error messages
+};
+
+/* Two-pass assembler. The first pass builds the label table, the second encodes .text instructions from
+   address 0 and .word values from the data region into memory. Errors are reported with their line numbers.
+   Returns the number of instructions, or -1 if the program has errors.
+
+   Syntax, one statement per line:   [label:] MNEMONIC operands   // comment (also # or ;)
+   Operands are separated by spaces or commas. BNE and J take a number or a label; immediates may also
+   name a label, which stands for its absolute word address. ".data" switches to the data section,
+   ".text" back, and ".word v1, v2, ..." places values in the current data location. */
+int assembleProgram(const struct SourceLine* lines, int lineCount, struct Memory* memory);
+
+int lookupMnemonic(const char* mnemonic, int length); // Case-insensitive, returns the opcode or -1
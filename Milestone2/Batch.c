@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include "Batch.h"
+#include "Cpu.h"
+#include "Pipeline.h"
+#include "OutOfOrder.h"
+#include "Trace.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct BatchResult {
+    bool loaded;
+    int cycles;
+    long long instructions;
+    uint64_t stateHash;
+};
+
+/* Shared by all workers; only nextProgram is written concurrently, under the lock */
+struct BatchQueue {
+    char** programs;
+    int programCount;
+    int nextProgram;
+    pthread_mutex_t lock;
+    const struct BatchOptions* options;
+    struct BatchResult* results; // One slot per program, each written by a single worker
+};
+
+static double nowSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void* batchWorker(void* argument) {
+    struct BatchQueue* queue = argument;
+    const struct BatchOptions* options = queue->options;
+    struct Cpu cpu;
+
+    initCpu(&cpu, options->instructionWords, options->dataWords);
+    initBranchPredictor(&cpu.predictor, options->predictor);
+    cpu.resolveStage = options->resolveStage;
+    cpu.forwarding = options->forwarding;
+    cpu.pipelineDepth = options->pipelineDepth;
+    cpu.memoryPorts = options->memoryPorts;
+    cpu.issueWidth = options->issueWidth;
+    cpu.storeBufferEntries = options->storeBufferEntries;
+    cpu.outOfOrderConfig = options->outOfOrderConfig;
+    memcpy(cpu.unitTimings, options->unitTimings, sizeof(cpu.unitTimings));
+    configureMemoryHierarchy(&cpu, &options->memoryHierarchy);
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->nextProgram++;
+        pthread_mutex_unlock(&queue->lock);
+        if (index >= queue->programCount) break;
+
+        struct BatchResult* result = &queue->results[index];
+        result->loaded = loadProgram(&cpu, queue->programs[index]);
+        if (!result->loaded) continue;
+
+        if (options->functionalMode) {
+            result->instructions = runFunctional(&cpu, options->dispatch);
+            result->cycles = 0;
+        } else {
+            result->cycles = options->outOfOrderMode ? runOutOfOrderToCompletion(&cpu) : runPipelineToCompletion(&cpu);
+            result->instructions = cpu.counters.instructionsRetired;
+        }
+        result->stateHash = hashCpuState(&cpu);
+    }
+    freeCpu(&cpu);
+    return NULL;
+}
+
+bool readProgramList(const char* path, char*** programs, int* programCount) {
+    FILE* list = fopen(path, "r");
+    char line[4096];
+    int capacity = *programCount;
+
+    if (list == NULL) {
+        printf("Error in opening file: %s\n", path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), list) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        if (length == 0) continue;
+
+        if (*programCount == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 64;
+            *programs = realloc(*programs, capacity * sizeof(char*));
+        }
+        char* program = malloc(length + 1);
+        memcpy(program, line, length);
+        program[length] = '\0';
+        (*programs)[(*programCount)++] = program;
+    }
+    fclose(list);
+    return true;
+}
+
+int runBatch(char** programs, int programCount, const struct BatchOptions* options) {
+    struct BatchQueue queue = { programs, programCount, 0, PTHREAD_MUTEX_INITIALIZER, options, NULL };
+    int jobs = options->jobs > 0 ? options->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int failed = 0;
+
+    if (jobs < 1) jobs = 1;
+    if (jobs > programCount) jobs = programCount > 0 ? programCount : 1;
+    traceLevel = TRACE_LEVEL_NONE; // Workers would interleave their output
+    queue.results = calloc(programCount > 0 ? programCount : 1, sizeof(struct BatchResult));
+
+    double start = nowSeconds();
+    pthread_t* workers = malloc(jobs * sizeof(pthread_t));
+    for (int i = 0; i < jobs; i++)
+        pthread_create(&workers[i], NULL, batchWorker, &queue);
+    for (int i = 0; i < jobs; i++)
+        pthread_join(workers[i], NULL);
+    double elapsed = nowSeconds() - start;
+
+    printf("%-40s %12s %14s %8s %18s\n", "program", "cycles", "instructions", "CPI", "state hash");
+    for (int i = 0; i < programCount; i++) {
+        const struct BatchResult* result = &queue.results[i];
+        if (!result->loaded) {
+            printf("%-40s %12s %14s %8s %18s\n", programs[i], "-", "-", "-", "load failed");
+            failed++;
+        } else if (options->functionalMode) {
+            printf("%-40s %12s %14lld %8s   %016" PRIx64 "\n", programs[i], "-", result->instructions, "-",
+                   result->stateHash);
+        } else {
+            printf("%-40s %12d %14lld %8.3f   %016" PRIx64 "\n", programs[i], result->cycles, result->instructions,
+                   result->instructions > 0 ? (double)result->cycles / result->instructions : 0.0, result->stateHash);
+        }
+    }
+    printf("%d programs, %d failed, %.3f s on %d thread%s\n", programCount, failed, elapsed, jobs, jobs == 1 ? "" : "s");
+
+    free(workers);
+    free(queue.results);
+    return failed;
+}
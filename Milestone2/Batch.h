@@ -0,0 +1,32 @@
+#pragma once
+#include "Functional.h"
+#include "Simulator.h"
+#include "Cache.h"
+#include <stdbool.h>
+
+struct BatchOptions {
+    bool functionalMode;
+    bool outOfOrderMode;
+    struct OutOfOrderConfig outOfOrderConfig;
+    enum DispatchStyle dispatch;
+    enum PredictorKind predictor;
+    enum ResolveStage resolveStage;
+    bool forwarding;
+    int pipelineDepth;
+    enum MemoryPorts memoryPorts;
+    int issueWidth;
+    int storeBufferEntries;
+    int instructionWords;
+    long long dataWords;
+    int jobs; // Worker threads, 0 for one per online core
+    struct UnitTiming unitTimings[UNIT_COUNT];
+    struct MemoryHierarchyConfig memoryHierarchy;
+};
+
+/* Appends the program paths listed one per line in path to *programs, growing it as needed */
+bool readProgramList(const char* path, char*** programs, int* programCount);
+
+/* Simulates every program on a pool of worker threads, each owning one Cpu that it reuses from program
+   to program, then prints one summary line per program in the order given: cycles, instructions, CPI
+   and the final-state hash. Tracing is turned off. Returns the number of programs that failed to load. */
+int runBatch(char** programs, int programCount, const struct BatchOptions* options);
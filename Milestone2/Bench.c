@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 200809L
+#include "Bench.h"
+#include "Cpu.h"
+#include "Functional.h"
+#include "Pipeline.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double nowNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+void runDispatchBenchmark(struct Cpu* cpu, int repeats) {
+    struct MemoryImage loadedMemory;
+    enum DispatchStyle styles[] = { DISPATCH_SWITCH, DISPATCH_HANDLERS, DISPATCH_THREADED };
+
+    captureMemory(&cpu->memory, &loadedMemory);
+
+    printf("%-10s %14s %14s %14s %10s\n", "dispatch", "instructions", "best ns/inst", "mean ns/inst", "MIPS");
+    for (int s = 0; s < 3; s++) {
+        long long instructions = 0;
+        double best = 0, total = 0;
+
+        for (int r = 0; r < repeats; r++) {
+            restoreMemory(&cpu->memory, &loadedMemory);
+            resetProcessor(cpu);
+            buildPredecodeTable(&cpu->predecode, &cpu->memory, cpu->lineCount);
+
+            double start = nowNanoseconds();
+            instructions = runFunctional(cpu, styles[s]);
+            double perInstruction = (nowNanoseconds() - start) / (instructions > 0 ? instructions : 1);
+
+            total += perInstruction;
+            if (r == 0 || perInstruction < best) best = perInstruction;
+        }
+
+        printf("%-10s %14lld %14.3f %14.3f %10.1f\n", dispatchStyleName(styles[s]), instructions, best,
+               total / repeats, 1e3 / best);
+    }
+
+    freeMemoryImage(&loadedMemory);
+}
+
+/* Straight-line mix of ALU, load and store instructions, addressing data through R10 = dataOffset */
+static bool writeScalingProgram(char* path, int instructionCount, int dataOffset) {
+    static const char* pattern[] = {
+        "ADDI R1 R1 1", "ADD R2 R2 R1", "SUB R3 R2 R1", "ANDI R4 R3 255",
+        "SW R3 R10 5", "LW R5 R10 5", "ORI R6 R5 1", "SLL R7 R6 1"
+    };
+    int descriptor = mkstemp(path);
+    if (descriptor < 0) return false;
+
+    FILE* file = fdopen(descriptor, "w");
+    fprintf(file, "ADDI R10 R0 %d\nSLL R10 R10 10\n", dataOffset / 1024);
+    for (int i = 2; i < instructionCount; i++)
+        fprintf(file, "%s\n", pattern[i % 8]);
+    fclose(file);
+    return true;
+}
+
+void runScalingBenchmark(struct Cpu* cpu) {
+    int savedTraceLevel = traceLevel;
+    traceLevel = TRACE_LEVEL_NONE;
+
+    printf("%12s %10s %10s %12s %12s %12s %12s %12s\n", "instructions", "load ms", "ns/inst",
+           "funct ms", "ns/inst", "cycles", "pipe ms", "ns/cycle");
+    for (int instructionCount = 10; instructionCount <= 1000000; instructionCount *= 10) {
+        char path[] = "/tmp/casim_scaling_XXXXXX";
+
+        // Instruction region rounded up to whole KiB-words so R10 can be built with one shift
+        int dataOffset = (instructionCount + 1023) / 1024 * 1024;
+        initMemory(&cpu->memory, dataOffset, DEFAULT_DATA_WORDS);
+        if (!writeScalingProgram(path, instructionCount, dataOffset)) {
+            printf("Cannot create a temporary program file\n");
+            break;
+        }
+
+        double start = nowNanoseconds();
+        bool loaded = loadProgram(cpu, path);
+        double loadTime = nowNanoseconds() - start;
+        unlink(path);
+        if (!loaded) break;
+
+        struct MemoryImage loadedMemory;
+        captureMemory(&cpu->memory, &loadedMemory);
+
+        start = nowNanoseconds();
+        long long instructions = runFunctional(cpu, DISPATCH_THREADED);
+        double functionalTime = nowNanoseconds() - start;
+
+        restoreMemory(&cpu->memory, &loadedMemory);
+        buildPredecodeTable(&cpu->predecode, &cpu->memory, cpu->lineCount);
+        resetProcessor(cpu);
+        start = nowNanoseconds();
+        int cycles = runPipelineToCompletion(cpu);
+        double pipelineTime = nowNanoseconds() - start;
+        freeMemoryImage(&loadedMemory);
+
+        printf("%12lld %10.3f %10.1f %12.3f %12.2f %12d %12.3f %12.2f\n", instructions, loadTime / 1e6,
+               loadTime / instructionCount, functionalTime / 1e6, functionalTime / instructions, cycles,
+               pipelineTime / 1e6, pipelineTime / cycles);
+    }
+
+    traceLevel = savedTraceLevel;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "Cpu.h"
+
+/* Times the functional interpreter on the program loaded into cpu under every dispatch style and
+   prints host nanoseconds per simulated instruction. */
+void runDispatchBenchmark(struct Cpu* cpu, int repeats);
+
+/* Generates straight-line programs of 10 to 1,000,000 instructions and prints load, functional and
+   pipelined simulation time for each, to show that all three grow linearly with program size. */
+void runScalingBenchmark(struct Cpu* cpu);
@@ -0,0 +1,129 @@
+#include "BinaryTrace.h"
+#include <string.h>
+
+#define BINARY_TRACE_BUFFER_SIZE (1 << 20)
+
+bool binaryTraceEnabled = false;
+
+static FILE* traceFile = NULL;
+static unsigned char traceBuffer[BINARY_TRACE_BUFFER_SIZE];
+static size_t traceBufferUsed = 0;
+static struct BinaryTraceRecord pendingRecord; // Events collected for the cycle in progress
+static int traceStageCount;
+
+static void flushTraceBuffer() {
+    if (traceBufferUsed > 0)
+        fwrite(traceBuffer, 1, traceBufferUsed, traceFile);
+    traceBufferUsed = 0;
+}
+
+static void writeTraceBytes(const void* data, size_t size) {
+    if (traceBufferUsed + size > BINARY_TRACE_BUFFER_SIZE)
+        flushTraceBuffer();
+    memcpy(traceBuffer + traceBufferUsed, data, size);
+    traceBufferUsed += size;
+}
+
+bool openBinaryTrace(const char* path, const struct BinaryTraceLayout* layout) {
+    traceFile = fopen(path, "wb");
+    if (traceFile == NULL) {
+        printf("Error in opening trace file: %s\n", path);
+        return false;
+    }
+
+    uint32_t header[3] = { BINARY_TRACE_MAGIC, BINARY_TRACE_VERSION, (uint32_t)layout->stageCount };
+    traceBufferUsed = 0;
+    writeTraceBytes(header, sizeof(header));
+    writeTraceBytes(layout->stageNames, layout->stageCount * BINARY_TRACE_STAGE_NAME);
+    traceStageCount = layout->stageCount;
+    pendingRecord.registerWriteCount = 0;
+    pendingRecord.memoryWriteCount = 0;
+    binaryTraceEnabled = true;
+    return true;
+}
+
+void traceRegisterWrite(int reg, int value) {
+    if (pendingRecord.registerWriteCount == BINARY_TRACE_MAX_EVENTS) return;
+    pendingRecord.registerWrites[pendingRecord.registerWriteCount].reg = reg;
+    pendingRecord.registerWrites[pendingRecord.registerWriteCount].value = value;
+    pendingRecord.registerWriteCount++;
+}
+
+void traceMemoryWrite(int address, int value) {
+    if (pendingRecord.memoryWriteCount == BINARY_TRACE_MAX_EVENTS) return;
+    pendingRecord.memoryWrites[pendingRecord.memoryWriteCount].address = address;
+    pendingRecord.memoryWrites[pendingRecord.memoryWriteCount].value = value;
+    pendingRecord.memoryWriteCount++;
+}
+
+void traceEndCycle(int cycle, int programCounter, const int* stageInstructions) {
+    uint32_t cycleNumber = (uint32_t)cycle;
+    int32_t pc = programCounter;
+    uint8_t counts[2] = { (uint8_t)pendingRecord.registerWriteCount, (uint8_t)pendingRecord.memoryWriteCount };
+
+    writeTraceBytes(&cycleNumber, sizeof(cycleNumber));
+    writeTraceBytes(&pc, sizeof(pc));
+    for (int i = 0; i < traceStageCount; i++) {
+        int32_t instruction = stageInstructions[i];
+        writeTraceBytes(&instruction, sizeof(instruction));
+    }
+    writeTraceBytes(counts, sizeof(counts));
+
+    for (int i = 0; i < pendingRecord.registerWriteCount; i++) {
+        uint8_t reg = (uint8_t)pendingRecord.registerWrites[i].reg;
+        writeTraceBytes(&reg, sizeof(reg));
+        writeTraceBytes(&pendingRecord.registerWrites[i].value, sizeof(int32_t));
+    }
+    for (int i = 0; i < pendingRecord.memoryWriteCount; i++) {
+        writeTraceBytes(&pendingRecord.memoryWrites[i].address, sizeof(int32_t));
+        writeTraceBytes(&pendingRecord.memoryWrites[i].value, sizeof(int32_t));
+    }
+
+    pendingRecord.registerWriteCount = 0;
+    pendingRecord.memoryWriteCount = 0;
+}
+
+void closeBinaryTrace() {
+    if (traceFile == NULL) return;
+    flushTraceBuffer();
+    fclose(traceFile);
+    traceFile = NULL;
+    binaryTraceEnabled = false;
+}
+
+bool readBinaryTraceHeader(FILE* file, struct BinaryTraceLayout* layout) {
+    uint32_t header[3];
+    if (fread(header, sizeof(header), 1, file) != 1) return false;
+    if (header[0] != BINARY_TRACE_MAGIC || header[1] != BINARY_TRACE_VERSION) return false;
+    if (header[2] == 0 || header[2] > BINARY_TRACE_MAX_STAGES) return false;
+
+    layout->stageCount = header[2];
+    if (fread(layout->stageNames, BINARY_TRACE_STAGE_NAME, layout->stageCount, file) != (size_t)layout->stageCount) return false;
+    for (int i = 0; i < layout->stageCount; i++)
+        layout->stageNames[i][BINARY_TRACE_STAGE_NAME - 1] = '\0';
+    return true;
+}
+
+bool readBinaryTraceRecord(FILE* file, const struct BinaryTraceLayout* layout, struct BinaryTraceRecord* record) {
+    uint8_t counts[2];
+
+    if (fread(&record->cycle, sizeof(uint32_t), 1, file) != 1) return false;
+    if (fread(&record->programCounter, sizeof(int32_t), 1, file) != 1) return false;
+    if (fread(record->stageInstructions, sizeof(int32_t), layout->stageCount, file) != (size_t)layout->stageCount) return false;
+    if (fread(counts, sizeof(counts), 1, file) != 1) return false;
+    if (counts[0] > BINARY_TRACE_MAX_EVENTS || counts[1] > BINARY_TRACE_MAX_EVENTS) return false;
+
+    record->registerWriteCount = counts[0];
+    record->memoryWriteCount = counts[1];
+    for (int i = 0; i < record->registerWriteCount; i++) {
+        uint8_t reg;
+        if (fread(&reg, sizeof(reg), 1, file) != 1) return false;
+        if (fread(&record->registerWrites[i].value, sizeof(int32_t), 1, file) != 1) return false;
+        record->registerWrites[i].reg = reg;
+    }
+    for (int i = 0; i < record->memoryWriteCount; i++) {
+        if (fread(&record->memoryWrites[i].address, sizeof(int32_t), 1, file) != 1) return false;
+        if (fread(&record->memoryWrites[i].value, sizeof(int32_t), 1, file) != 1) return false;
+    }
+    return true;
+}
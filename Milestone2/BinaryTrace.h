@@ -0,0 +1,46 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BINARY_TRACE_MAGIC 0x54534143u // "CAST"
+#define BINARY_TRACE_VERSION 2
+#define BINARY_TRACE_MAX_STAGES 64 // Columns: one per stage, or per issue slot of each stage
+#define BINARY_TRACE_STAGE_NAME 8 // Bytes per stage name, NUL padded
+#define BINARY_TRACE_MAX_EVENTS 16 // Per kind, per cycle
+
+/* File layout, host byte order:
+   header:     uint32 magic, uint32 version, uint32 stageCount, stageCount x char[BINARY_TRACE_STAGE_NAME]
+   per cycle:  uint32 cycle, int32 programCounter, int32 stageInstructions[stageCount], IF first,
+               uint8 registerWriteCount, uint8 memoryWriteCount,
+               registerWriteCount x { uint8 register, int32 value },
+               memoryWriteCount   x { int32 address, int32 value } */
+
+/* The stages a trace records, in pipeline order */
+struct BinaryTraceLayout {
+    int stageCount;
+    char stageNames[BINARY_TRACE_MAX_STAGES][BINARY_TRACE_STAGE_NAME];
+};
+
+struct BinaryTraceRecord {
+    uint32_t cycle;
+    int32_t programCounter;
+    int32_t stageInstructions[BINARY_TRACE_MAX_STAGES];
+    int registerWriteCount;
+    int memoryWriteCount;
+    struct { int reg; int32_t value; } registerWrites[BINARY_TRACE_MAX_EVENTS];
+    struct { int32_t address; int32_t value; } memoryWrites[BINARY_TRACE_MAX_EVENTS];
+};
+
+extern bool binaryTraceEnabled;
+
+/* Writer side, used by the simulator. Records go through a large in-memory buffer. */
+bool openBinaryTrace(const char* path, const struct BinaryTraceLayout* layout);
+void traceRegisterWrite(int reg, int value);
+void traceMemoryWrite(int address, int value);
+void traceEndCycle(int cycle, int programCounter, const int* stageInstructions); // One word per stage of the layout
+void closeBinaryTrace();
+
+/* Reader side, used by the offline decoder */
+bool readBinaryTraceHeader(FILE* file, struct BinaryTraceLayout* layout);
+bool readBinaryTraceRecord(FILE* file, const struct BinaryTraceLayout* layout, struct BinaryTraceRecord* record);
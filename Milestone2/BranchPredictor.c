@@ -0,0 +1,88 @@
+#include "BranchPredictor.h"
+#include <string.h>
+
+void initBranchPredictor(struct BranchPredictor* predictor, enum PredictorKind kind) {
+    predictor->kind = kind;
+    resetBranchPredictor(predictor);
+}
+
+void resetBranchPredictor(struct BranchPredictor* predictor) {
+    predictor->history = 0;
+    memset(predictor->counters, 1, sizeof(predictor->counters)); // Weakly not taken
+    for (int i = 0; i < BTB_SIZE; i++)
+        predictor->targets[i].pc = -1;
+}
+
+static int counterIndexFor(const struct BranchPredictor* predictor, int pc) {
+    uint32_t index = (uint32_t)pc;
+    if (predictor->kind == PREDICTOR_GSHARE) index ^= predictor->history;
+    return (int)(index & (PREDICTOR_TABLE_SIZE - 1));
+}
+
+struct BranchPrediction predictBranch(const struct BranchPredictor* predictor, int pc) {
+    const struct BranchTargetEntry* entry = &predictor->targets[pc & (BTB_SIZE - 1)];
+    struct BranchPrediction prediction = { false, false, 0, 0, false };
+
+    if (entry->pc != pc) return prediction; // Not known to be a branch, fetch falls through
+    prediction.targetKnown = true;
+    prediction.target = entry->target;
+    prediction.counterIndex = counterIndexFor(predictor, pc);
+
+    if (entry->isJump) {
+        prediction.taken = true;
+        return prediction;
+    }
+    switch (predictor->kind) {
+        case PREDICTOR_NOT_TAKEN:
+            break;
+        case PREDICTOR_BTFN:
+            prediction.taken = entry->target <= pc;
+            break;
+        case PREDICTOR_BIMODAL:
+        case PREDICTOR_GSHARE:
+            prediction.taken = predictor->counters[prediction.counterIndex] >= 2;
+            break;
+    }
+    return prediction;
+}
+
+void updateBranchPredictor(struct BranchPredictor* predictor, const struct BranchPrediction* prediction, int pc,
+                           bool isBranch, bool isJump, bool taken, int target) {
+    struct BranchTargetEntry* entry = &predictor->targets[pc & (BTB_SIZE - 1)];
+
+    if (!isBranch) {
+        if (entry->pc == pc) entry->pc = -1; // The branch was overwritten by a store
+        return;
+    }
+    if (taken) {
+        entry->pc = pc;
+        entry->target = target;
+        entry->isJump = isJump;
+    }
+    if (isJump) return;
+
+    // A BTB miss consulted no counter, so train the one the next lookup will use
+    int index = prediction->targetKnown ? prediction->counterIndex : counterIndexFor(predictor, pc);
+    uint8_t* counter = &predictor->counters[index];
+    if (taken && *counter < 3) (*counter)++;
+    if (!taken && *counter > 0) (*counter)--;
+    predictor->history = ((predictor->history << 1) | taken) & (PREDICTOR_TABLE_SIZE - 1);
+}
+
+const char* predictorKindName(enum PredictorKind kind) {
+    switch (kind) {
+        case PREDICTOR_NOT_TAKEN: return "not-taken";
+        case PREDICTOR_BTFN:      return "btfn";
+        case PREDICTOR_BIMODAL:   return "bimodal";
+        case PREDICTOR_GSHARE:    return "gshare";
+        default:                  return "unknown";
+    }
+}
+
+int parsePredictorKind(const char* name) {
+    if (strcmp(name, "not-taken") == 0) return PREDICTOR_NOT_TAKEN;
+    if (strcmp(name, "btfn") == 0) return PREDICTOR_BTFN;
+    if (strcmp(name, "bimodal") == 0) return PREDICTOR_BIMODAL;
+    if (strcmp(name, "gshare") == 0) return PREDICTOR_GSHARE;
+    return -1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Next-PC prediction consulted by IF. The branch target buffer recognises BNEs and Js by the address
+   they were fetched from, the direction predictor decides whether a BNE found there is taken. */
+
+#define PREDICTOR_TABLE_BITS 12  // 4096 two-bit counters
+#define PREDICTOR_TABLE_SIZE (1 << PREDICTOR_TABLE_BITS)
+#define BTB_BITS 10              // 1024 direct-mapped entries, tagged with the full PC
+#define BTB_SIZE (1 << BTB_BITS)
+
+enum PredictorKind {
+    PREDICTOR_NOT_TAKEN, // BNEs always fall through
+    PREDICTOR_BTFN,      // Backward taken, forward not taken
+    PREDICTOR_BIMODAL,   // Two-bit saturating counter per PC
+    PREDICTOR_GSHARE     // Two-bit counters indexed by PC xor global history
+};
+
+#define DEFAULT_PREDICTOR PREDICTOR_BIMODAL
+
+struct BranchTargetEntry {
+    int pc; // -1 when empty
+    int target;
+    bool isJump;
+};
+
+/* Travels down the pipeline with the instruction it was made for */
+struct BranchPrediction {
+    bool taken;
+    bool targetKnown; // BTB hit
+    int target;
+    int counterIndex; // Counter consulted, so the update trains the same one
+    bool resolved;    // Already checked against the real outcome by an earlier stage
+};
+
+struct BranchPredictor {
+    enum PredictorKind kind;
+    uint32_t history; // Outcomes of the most recent resolved BNEs, newest in bit 0
+    uint8_t counters[PREDICTOR_TABLE_SIZE];
+    struct BranchTargetEntry targets[BTB_SIZE];
+};
+
+void initBranchPredictor(struct BranchPredictor* predictor, enum PredictorKind kind);
+void resetBranchPredictor(struct BranchPredictor* predictor); // Forgets all history, keeps the kind
+
+struct BranchPrediction predictBranch(const struct BranchPredictor* predictor, int pc);
+
+/* Trains the predictor with the outcome resolved in EX. isBranch is false for anything other than
+   BNE or J, which only matters if the BTB still remembers a branch that has since been overwritten. */
+void updateBranchPredictor(struct BranchPredictor* predictor, const struct BranchPrediction* prediction, int pc,
+                           bool isBranch, bool isJump, bool taken, int target);
+
+const char* predictorKindName(enum PredictorKind kind);
+int parsePredictorKind(const char* name); // Returns -1 for an unknown name
@@ -0,0 +1,356 @@
+#include "Cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_SEED 0x9E3779B9u
+
+void initCacheConfig(struct CacheConfig* config) {
+    config->enabled = false;
+    config->sizeWords = 1024;
+    config->ways = 2;
+    config->lineWords = 8;
+    config->replacement = REPLACE_LRU;
+    config->writeBack = true;
+    config->hitLatency = 1;
+    config->missPenalty = 20;
+    config->mshrs = 8;
+}
+
+void initMemoryHierarchyConfig(struct MemoryHierarchyConfig* config) {
+    initCacheConfig(&config->instructionCache);
+    initCacheConfig(&config->dataCache);
+    initCacheConfig(&config->l2Cache);
+    config->l2Cache.sizeWords = 16384;
+    config->l2Cache.ways = 8;
+    config->l2Cache.hitLatency = 10;
+    config->l2Cache.missPenalty = 100;
+    config->l2Cache.mshrs = 16;
+    initDramConfig(&config->dram);
+    initPrefetcherConfig(&config->prefetcher);
+}
+
+static bool isPowerOfTwo(long value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+static int log2Of(int value) {
+    int bits = 0;
+    while ((1 << bits) < value) bits++;
+    return bits;
+}
+
+static bool parseNumber(const char* name, const char* key, const char* text, long minimum, long maximum, bool powerOfTwo, int* field) {
+    char* end;
+    long value = strtol(text, &end, 10);
+
+    if (*end != '\0' || value < minimum || value > maximum || (powerOfTwo && !isPowerOfTwo(value))) {
+        printf("%s setting %s must be %s%ld to %ld: %s\n", name, key, powerOfTwo ? "a power of two from " : "", minimum, maximum, text);
+        return false;
+    }
+    *field = (int)value;
+    return true;
+}
+
+static bool applySetting(struct CacheConfig* config, const char* name, const char* key, const char* value) {
+    if (strcmp(key, "size") == 0) return parseNumber(name, key, value, 1, MAX_CACHE_WORDS, true, &config->sizeWords);
+    if (strcmp(key, "ways") == 0) return parseNumber(name, key, value, 1, MAX_CACHE_WAYS, true, &config->ways);
+    if (strcmp(key, "line") == 0) return parseNumber(name, key, value, 1, MAX_CACHE_LINE_WORDS, true, &config->lineWords);
+    if (strcmp(key, "hit") == 0) return parseNumber(name, key, value, 1, MAX_CACHE_LATENCY, false, &config->hitLatency);
+    if (strcmp(key, "miss") == 0) return parseNumber(name, key, value, 0, MAX_CACHE_LATENCY, false, &config->missPenalty);
+    if (strcmp(key, "mshrs") == 0) return parseNumber(name, key, value, 1, MAX_MSHRS, false, &config->mshrs);
+    if (strcmp(key, "policy") == 0) {
+        if (strcmp(value, "lru") == 0) config->replacement = REPLACE_LRU;
+        else if (strcmp(value, "plru") == 0) config->replacement = REPLACE_PLRU;
+        else if (strcmp(value, "random") == 0) config->replacement = REPLACE_RANDOM;
+        else {
+            printf("%s setting policy must be lru, plru or random: %s\n", name, value);
+            return false;
+        }
+        return true;
+    }
+    if (strcmp(key, "write") == 0) {
+        if (strcmp(value, "back") == 0) config->writeBack = true;
+        else if (strcmp(value, "through") == 0) config->writeBack = false;
+        else {
+            printf("%s setting write must be back or through: %s\n", name, value);
+            return false;
+        }
+        return true;
+    }
+    printf("Unknown %s setting: %s\n", name, key);
+    return false;
+}
+
+bool parseCacheConfig(struct CacheConfig* config, const char* name, const char* settings) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    config->enabled = true;
+    if (strcmp(settings, "on") == 0) return true;
+    for (char* setting = strtok(buffer, ","); setting != NULL; setting = strtok(NULL, ",")) {
+        char* separator = strchr(setting, '=');
+        if (separator == NULL) {
+            printf("%s settings are key=value pairs: %s\n", name, setting);
+            return false;
+        }
+        *separator = '\0';
+        if (!applySetting(config, name, setting, separator + 1)) return false;
+    }
+    if (config->sizeWords < config->ways * config->lineWords) {
+        printf("%s of %d words cannot hold %d ways of %d-word lines\n", name, config->sizeWords, config->ways, config->lineWords);
+        return false;
+    }
+    return true;
+}
+
+void configureCache(struct Cache* cache, const struct CacheConfig* config, struct CacheCounters* counters, struct Cache* next,
+                    struct Dram* dram) {
+    freeCache(cache);
+    cache->config = *config;
+    cache->counters = counters;
+    cache->next = next;
+    cache->dram = dram;
+    cache->prefetcher = NULL;
+    if (!config->enabled) return;
+    cache->sets = config->sizeWords / (config->ways * config->lineWords);
+    cache->offsetBits = log2Of(config->lineWords);
+    cache->setBits = log2Of(cache->sets);
+    cache->lines = malloc((size_t)cache->sets * config->ways * sizeof(struct CacheLine));
+    cache->plruBits = malloc(cache->sets * sizeof(uint32_t));
+    resetCache(cache);
+}
+
+void resetCache(struct Cache* cache) {
+    if (cache->lines == NULL) return;
+    memset(cache->lines, 0, (size_t)cache->sets * cache->config.ways * sizeof(struct CacheLine));
+    memset(cache->plruBits, 0, cache->sets * sizeof(uint32_t));
+    memset(cache->mshrReady, 0, sizeof(cache->mshrReady));
+    cache->randomState = RANDOM_SEED;
+    cache->useClock = 0;
+}
+
+void freeCache(struct Cache* cache) {
+    free(cache->lines);
+    free(cache->plruBits);
+    cache->lines = NULL;
+    cache->plruBits = NULL;
+}
+
+/* Tree pseudo-LRU: each node on the way down to the used way is turned to point at the other half */
+static void touchPlru(struct Cache* cache, int set, int way) {
+    int levels = log2Of(cache->config.ways);
+    int node = 1;
+
+    for (int level = levels - 1; level >= 0; level--) {
+        int right = (way >> level) & 1;
+        if (right) cache->plruBits[set] &= ~(1u << node);
+        else cache->plruBits[set] |= 1u << node;
+        node = 2 * node + right;
+    }
+}
+
+static int plruVictim(const struct Cache* cache, int set) {
+    int levels = log2Of(cache->config.ways);
+    int node = 1, way = 0;
+
+    for (int level = 0; level < levels; level++) {
+        int right = (cache->plruBits[set] >> node) & 1;
+        way = 2 * way + right;
+        node = 2 * node + right;
+    }
+    return way;
+}
+
+/* An invalid way if there is one, otherwise the one the replacement policy picks */
+static int chooseVictim(struct Cache* cache, int set, const struct CacheLine* lines) {
+    int ways = cache->config.ways;
+    int victim = 0;
+
+    for (int way = 0; way < ways; way++)
+        if (!lines[way].valid) return way;
+    switch (cache->config.replacement) {
+        case REPLACE_PLRU:
+            return plruVictim(cache, set);
+        case REPLACE_RANDOM:
+            // xorshift32, reseeded on reset so runs are repeatable
+            cache->randomState ^= cache->randomState << 13;
+            cache->randomState ^= cache->randomState >> 17;
+            cache->randomState ^= cache->randomState << 5;
+            return cache->randomState & (ways - 1);
+        default:
+            for (int way = 1; way < ways; way++)
+                if (lines[way].lastUse < lines[victim].lastUse) victim = way;
+            return victim;
+    }
+}
+
+static void touch(struct Cache* cache, int set, int way) {
+    cache->lines[set * cache->config.ways + way].lastUse = ++cache->useClock;
+    if (cache->config.replacement == REPLACE_PLRU) touchPlru(cache, set, way);
+}
+
+static uint32_t lineAddressOf(const struct Cache* cache, int set, uint32_t tag) {
+    return ((tag << cache->setBits) | (uint32_t)set) << cache->offsetBits;
+}
+
+static void writeLine(struct Cache* cache, uint32_t address, int cycle);
+
+/* A dirty line or a written-through store handed to the level below. Buffered, so the requester does
+   not wait for it, but it still updates the state below. */
+static void writeDown(struct Cache* cache, uint32_t address, int cycle) {
+    if (cache->next != NULL) writeLine(cache->next, address, cycle);
+    else if (cache->dram != NULL) accessDram(cache->dram, address, true, cycle);
+}
+
+static void evict(struct Cache* cache, int set, struct CacheLine* line, int cycle) {
+    if (line->valid && line->prefetched) cache->prefetcher->counters->unused++;
+    if (!line->valid || !line->dirty) return;
+    cache->counters->writebacks++;
+    writeDown(cache, lineAddressOf(cache, set, line->tag), cycle);
+}
+
+/* A write from the level above. A written-back line is whole, so a miss allocates without a fill. */
+static void writeLine(struct Cache* cache, uint32_t address, int cycle) {
+    uint32_t lineAddress = address >> cache->offsetBits;
+    int set = lineAddress & (cache->sets - 1);
+    uint32_t tag = lineAddress >> cache->setBits;
+    struct CacheLine* lines = &cache->lines[set * cache->config.ways];
+
+    cache->counters->writes++;
+    for (int way = 0; way < cache->config.ways; way++) {
+        if (!lines[way].valid || lines[way].tag != tag) continue;
+        touch(cache, set, way);
+        if (cache->config.writeBack) {
+            lines[way].dirty = true;
+        } else {
+            cache->counters->writesThrough++;
+            writeDown(cache, address, cycle);
+        }
+        return;
+    }
+    cache->counters->writeMisses++;
+    if (!cache->config.writeBack) {
+        cache->counters->writesThrough++;
+        writeDown(cache, address, cycle);
+        return;
+    }
+    int way = chooseVictim(cache, set, lines);
+    evict(cache, set, &lines[way], cycle);
+    lines[way] = (struct CacheLine){ .tag = tag, .valid = true, .dirty = true, .lastUse = 0, .fillCycle = cycle, .prefetched = false };
+    touch(cache, set, way);
+}
+
+/* The MSHR a miss at cycle takes, the one freeing up first when all are busy, and when it has it */
+static int claimMshr(const struct Cache* cache, int cycle, int* start) {
+    int earliest = 0;
+    for (int mshr = 0; mshr < cache->config.mshrs; mshr++) {
+        if (cache->mshrReady[mshr] <= cycle) {
+            *start = cycle;
+            return mshr;
+        }
+        if (cache->mshrReady[mshr] < cache->mshrReady[earliest]) earliest = mshr;
+    }
+    *start = cache->mshrReady[earliest];
+    return earliest;
+}
+
+/* Cycles from cycle until the level below has delivered the line holding address */
+static int fillLine(struct Cache* cache, uint32_t address, int cycle) {
+    address &= ~(uint32_t)(cache->config.lineWords - 1);
+    if (cache->next != NULL) return accessCache(cache->next, -1, address, false, cycle);
+    if (cache->dram != NULL) return accessDram(cache->dram, address, false, cycle);
+    return cache->config.missPenalty;
+}
+
+/* The access itself, setting triggered when it missed or was the first use of a prefetched line */
+static int demandAccess(struct Cache* cache, uint32_t address, bool write, int cycle, bool* triggered) {
+    const struct CacheConfig* config = &cache->config;
+    struct CacheCounters* counters = cache->counters;
+    uint32_t lineAddress = address >> cache->offsetBits;
+    int set = lineAddress & (cache->sets - 1);
+    uint32_t tag = lineAddress >> cache->setBits;
+    struct CacheLine* lines = &cache->lines[set * config->ways];
+
+    if (write) counters->writes++;
+    else counters->reads++;
+    for (int way = 0; way < config->ways; way++) {
+        if (!lines[way].valid || lines[way].tag != tag) continue;
+        touch(cache, set, way);
+        bool late = lines[way].fillCycle > cycle + config->hitLatency;
+        if (lines[way].prefetched) {
+            lines[way].prefetched = false;
+            cache->prefetcher->counters->useful++;
+            if (late) cache->prefetcher->counters->late++;
+            *triggered = true;
+        }
+        if (write && config->writeBack) lines[way].dirty = true;
+        if (write && !config->writeBack) {
+            counters->writesThrough++;
+            writeDown(cache, address, cycle);
+        }
+        // The line's fill is still outstanding: this access merges into its MSHR and waits for the fill
+        if (late) {
+            counters->mshrMerges++;
+            return lines[way].fillCycle - cycle;
+        }
+        return config->hitLatency;
+    }
+
+    *triggered = true;
+    if (write) counters->writeMisses++;
+    else counters->readMisses++;
+    if (write && !config->writeBack) {
+        counters->writesThrough++; // No allocation, the store goes straight on down
+        writeDown(cache, address, cycle);
+        return config->hitLatency;
+    }
+    int start;
+    int mshr = claimMshr(cache, cycle, &start);
+    counters->mshrWaitCycles += start - cycle;
+    int way = chooseVictim(cache, set, lines);
+    evict(cache, set, &lines[way], start);
+    int ready = start + config->hitLatency + fillLine(cache, address, start + config->hitLatency);
+    lines[way] = (struct CacheLine){ .tag = tag, .valid = true, .dirty = write, .lastUse = 0, .fillCycle = ready, .prefetched = false };
+    touch(cache, set, way);
+    cache->mshrReady[mshr] = ready;
+    return ready - cycle;
+}
+
+/* Brings in the line at address ahead of its use, unless it is already cached or every MSHR is busy.
+   Not a demand access, so it only counts as a read in the levels below. */
+static void prefetchLine(struct Cache* cache, uint32_t address, int cycle) {
+    struct PrefetchCounters* counters = cache->prefetcher->counters;
+    uint32_t lineAddress = address >> cache->offsetBits;
+    int set = lineAddress & (cache->sets - 1);
+    uint32_t tag = lineAddress >> cache->setBits;
+    struct CacheLine* lines = &cache->lines[set * cache->config.ways];
+    int start;
+
+    for (int way = 0; way < cache->config.ways; way++)
+        if (lines[way].valid && lines[way].tag == tag) return;
+    int mshr = claimMshr(cache, cycle, &start);
+    if (start > cycle) {
+        counters->dropped++;
+        return;
+    }
+    counters->issued++;
+    int way = chooseVictim(cache, set, lines);
+    evict(cache, set, &lines[way], cycle);
+    int ready = cycle + cache->config.hitLatency + fillLine(cache, address, cycle + cache->config.hitLatency);
+    lines[way] = (struct CacheLine){ .tag = tag, .valid = true, .dirty = false, .lastUse = 0, .fillCycle = ready, .prefetched = true };
+    touch(cache, set, way);
+    cache->mshrReady[mshr] = ready;
+}
+
+int accessCache(struct Cache* cache, int pc, uint32_t address, bool write, int cycle) {
+    bool triggered = false;
+    int cycles = demandAccess(cache, address, write, cycle, &triggered);
+
+    if (cache->prefetcher != NULL) {
+        uint32_t lines[MAX_PREFETCH_DEGREE];
+        int count = predictPrefetches(cache->prefetcher, pc, address, triggered, lines);
+        for (int i = 0; i < count; i++) prefetchLine(cache, lines[i], cycle);
+    }
+    return cycles;
+}
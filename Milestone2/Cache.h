@@ -0,0 +1,86 @@
+#pragma once
+#include "Counters.h"
+#include "Dram.h"
+#include "Prefetcher.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_CACHE_WAYS 16
+#define MAX_CACHE_LINE_WORDS 64
+#define MAX_CACHE_WORDS (1 << 24)
+#define MAX_CACHE_LATENCY 10000
+#define MAX_MSHRS 32
+
+enum ReplacementPolicy { REPLACE_LRU, REPLACE_PLRU, REPLACE_RANDOM };
+
+/* Geometry and timing of one cache, sizes in words. Sizes, ways and line length are powers of two. */
+struct CacheConfig {
+    bool enabled;        // Off, every access takes a single cycle as without a cache
+    int sizeWords;
+    int ways;
+    int lineWords;
+    enum ReplacementPolicy replacement;
+    bool writeBack;      // Write-back with write-allocate, or write-through without allocating on a store miss
+    int hitLatency;      // Cycles for a hit
+    int missPenalty;     // Cycles to fill a line when there is no level below
+    int mshrs;           // Misses that can be outstanding at once
+};
+
+struct CacheLine {
+    uint32_t tag;
+    bool valid;
+    bool dirty;
+    long long lastUse; // For LRU
+    int fillCycle;     // When the line's data arrives; later than now while its miss is outstanding
+    bool prefetched;   // Brought in by the prefetcher and not used yet
+};
+
+/* Tags and replacement state only: the data stays in Memory, which the engines keep reading and
+   writing directly, so a cache changes timing and never values. Misses go to the next cache, to the
+   DRAM or, with neither, take the fixed miss penalty. */
+struct Cache {
+    struct CacheConfig config;
+    int sets;
+    int offsetBits, setBits;
+    struct CacheLine* lines; // sets x ways, NULL while disabled
+    uint32_t* plruBits;      // Per set, node n of the binary tree in bit n, a set bit pointing right
+    uint32_t randomState;
+    long long useClock;
+    int mshrReady[MAX_MSHRS]; // Cycle each miss status holding register frees up
+    struct Cache* next;
+    struct Dram* dram;
+    struct Prefetcher* prefetcher; // Trained on the demand accesses, NULL for none
+    struct CacheCounters* counters;
+};
+
+/* Every level of the memory hierarchy: split L1s, a unified L2 behind both and the DRAM, and the
+   prefetcher feeding the D-cache */
+struct MemoryHierarchyConfig {
+    struct CacheConfig instructionCache, dataCache, l2Cache;
+    struct DramConfig dram;
+    struct PrefetcherConfig prefetcher;
+};
+
+/* L1 defaults: 1024 words, 2 ways of 8-word lines, LRU, write-back, hit in 1 cycle and 20 more on a
+   miss, 8 MSHRs; disabled */
+void initCacheConfig(struct CacheConfig* config);
+/* L1 defaults for both L1s; the L2 16384 words, 8 ways, hit in 10 cycles, 100 more on a miss, 16 MSHRs;
+   no prefetcher */
+void initMemoryHierarchyConfig(struct MemoryHierarchyConfig* config);
+
+/* Enables the cache and applies comma-separated key=value settings, or just enables it for "on". Keys:
+   size, ways, line, policy (lru, plru or random), write (back or through), hit, miss and mshrs. Returns
+   false, having printed why, on an unknown key or a value out of range. */
+bool parseCacheConfig(struct CacheConfig* config, const char* name, const char* settings);
+
+/* Allocates the tags, all invalid, and connects the cache to the level below, next or dram, either
+   possibly NULL. Leaves it without a prefetcher. */
+void configureCache(struct Cache* cache, const struct CacheConfig* config, struct CacheCounters* counters, struct Cache* next,
+                    struct Dram* dram);
+void resetCache(struct Cache* cache); // Invalidates every line
+void freeCache(struct Cache* cache);
+
+/* Looks up the word at address for the instruction at pc, -1 for a fill from the level above, at the
+   given cycle, filling its line on a miss that allocates. Then has the prefetcher, if any, bring in the
+   lines it predicts. Returns the cycles until the access is done. */
+int accessCache(struct Cache* cache, int pc, uint32_t address, bool write, int cycle);
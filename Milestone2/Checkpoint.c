@@ -0,0 +1,256 @@
+#include "Checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct CheckpointHeader {
+    uint32_t magic, version, engine;
+    uint64_t fingerprint;
+    int64_t memorySize;
+    int32_t dataOffset;
+};
+
+const char* checkpointEngineName(enum CheckpointEngine engine) {
+    switch (engine) {
+        case CHECKPOINT_FUNCTIONAL:     return "functional mode";
+        case CHECKPOINT_PIPELINE:       return "pipeline";
+        case CHECKPOINT_OUT_OF_ORDER:   return "out-of-order core";
+        default:                        return "unknown";
+    }
+}
+
+static bool put(FILE* file, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+static bool take(FILE* file, void* data, size_t size) {
+    return size == 0 || fread(data, 1, size, file) == size;
+}
+
+/* FNV-1a over every setting that shapes the structures in the engine section */
+static uint64_t mix(uint64_t hash, long long value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (uint64_t)(value >> (8 * i)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t mixCache(uint64_t hash, const struct CacheConfig* config) {
+    hash = mix(hash, config->enabled);
+    hash = mix(hash, config->sizeWords);
+    hash = mix(hash, config->ways);
+    hash = mix(hash, config->lineWords);
+    hash = mix(hash, config->replacement);
+    hash = mix(hash, config->writeBack);
+    hash = mix(hash, config->hitLatency);
+    hash = mix(hash, config->missPenalty);
+    return mix(hash, config->mshrs);
+}
+
+static uint64_t configurationFingerprint(const struct Cpu* cpu) {
+    uint64_t hash = 14695981039346656037ull;
+    const struct DramConfig* dram = &cpu->dram.config;
+    const struct PrefetcherConfig* prefetcher = &cpu->prefetcher.config;
+
+    hash = mix(hash, cpu->pipelineDepth);
+    hash = mix(hash, cpu->memoryPorts);
+    hash = mix(hash, cpu->issueWidth);
+    hash = mix(hash, cpu->storeBufferEntries);
+    hash = mix(hash, cpu->resolveStage);
+    hash = mix(hash, cpu->forwarding);
+    hash = mix(hash, cpu->predictor.kind);
+    hash = mix(hash, cpu->outOfOrderConfig.reorderBufferSize);
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        hash = mix(hash, cpu->outOfOrderConfig.stations[unit]);
+        hash = mix(hash, cpu->outOfOrderConfig.units[unit]);
+        hash = mix(hash, cpu->unitTimings[unit].latency);
+        hash = mix(hash, cpu->unitTimings[unit].pipelined);
+    }
+    hash = mixCache(hash, &cpu->instructionCache.config);
+    hash = mixCache(hash, &cpu->dataCache.config);
+    hash = mixCache(hash, &cpu->l2Cache.config);
+    hash = mix(hash, dram->enabled);
+    hash = mix(hash, dram->banks);
+    hash = mix(hash, dram->rowWords);
+    hash = mix(hash, dram->tCAS);
+    hash = mix(hash, dram->tRCD);
+    hash = mix(hash, dram->tRP);
+    hash = mix(hash, prefetcher->kind);
+    hash = mix(hash, prefetcher->degree);
+    hash = mix(hash, prefetcher->distance);
+    return mix(hash, prefetcher->tableEntries);
+}
+
+/* Sizes of a cache's replacement state, zero while it is disabled */
+static size_t cacheLineBytes(const struct Cache* cache) {
+    return cache->lines != NULL ? (size_t)cache->sets * cache->config.ways * sizeof(struct CacheLine) : 0;
+}
+
+static size_t cachePlruBytes(const struct Cache* cache) {
+    return cache->lines != NULL ? cache->sets * sizeof(uint32_t) : 0;
+}
+
+static size_t prefetcherBytes(const struct Prefetcher* prefetcher) {
+    return prefetcher->entries != NULL ? prefetcher->config.tableEntries * sizeof(struct PrefetchEntry) : 0;
+}
+
+static bool putCache(FILE* file, const struct Cache* cache) {
+    return put(file, cache->lines, cacheLineBytes(cache)) && put(file, cache->plruBits, cachePlruBytes(cache)) &&
+           put(file, &cache->randomState, sizeof(cache->randomState)) && put(file, &cache->useClock, sizeof(cache->useClock)) &&
+           put(file, cache->mshrReady, sizeof(cache->mshrReady));
+}
+
+static bool takeCache(FILE* file, struct Cache* cache) {
+    return take(file, cache->lines, cacheLineBytes(cache)) && take(file, cache->plruBits, cachePlruBytes(cache)) &&
+           take(file, &cache->randomState, sizeof(cache->randomState)) && take(file, &cache->useClock, sizeof(cache->useClock)) &&
+           take(file, cache->mshrReady, sizeof(cache->mshrReady));
+}
+
+/* Everything only a timed engine has: the cycle, the counters, the state in flight and in the predictor,
+   the caches, the DRAM and the prefetcher */
+static bool putEngine(FILE* file, struct Cpu* cpu, enum CheckpointEngine engine) {
+    bool ok = put(file, &cpu->cycle, sizeof(cpu->cycle)) && put(file, &cpu->counters, sizeof(cpu->counters)) &&
+              put(file, &cpu->predictor, sizeof(cpu->predictor));
+    if (engine == CHECKPOINT_PIPELINE) ok = ok && put(file, &cpu->pipeline, sizeof(cpu->pipeline));
+    else ok = ok && put(file, &cpu->outOfOrder, sizeof(cpu->outOfOrder));
+    return ok && putCache(file, &cpu->instructionCache) && putCache(file, &cpu->dataCache) && putCache(file, &cpu->l2Cache) &&
+           put(file, cpu->dram.banks, cpu->dram.config.banks * sizeof(struct DramBank)) &&
+           put(file, cpu->prefetcher.entries, prefetcherBytes(&cpu->prefetcher)) &&
+           put(file, &cpu->prefetcher.useClock, sizeof(cpu->prefetcher.useClock));
+}
+
+static bool takeEngine(FILE* file, struct Cpu* cpu, enum CheckpointEngine engine) {
+    bool ok = take(file, &cpu->cycle, sizeof(cpu->cycle)) && take(file, &cpu->counters, sizeof(cpu->counters)) &&
+              take(file, &cpu->predictor, sizeof(cpu->predictor));
+    if (engine == CHECKPOINT_PIPELINE) ok = ok && take(file, &cpu->pipeline, sizeof(cpu->pipeline));
+    else ok = ok && take(file, &cpu->outOfOrder, sizeof(cpu->outOfOrder));
+    return ok && takeCache(file, &cpu->instructionCache) && takeCache(file, &cpu->dataCache) && takeCache(file, &cpu->l2Cache) &&
+           take(file, cpu->dram.banks, cpu->dram.config.banks * sizeof(struct DramBank)) &&
+           take(file, cpu->prefetcher.entries, prefetcherBytes(&cpu->prefetcher)) &&
+           take(file, &cpu->prefetcher.useClock, sizeof(cpu->prefetcher.useClock));
+}
+
+/* Field by field, so no padding reaches the file */
+static bool putHeader(FILE* file, const struct CheckpointHeader* header) {
+    return put(file, &header->magic, sizeof(header->magic)) && put(file, &header->version, sizeof(header->version)) &&
+           put(file, &header->engine, sizeof(header->engine)) && put(file, &header->fingerprint, sizeof(header->fingerprint)) &&
+           put(file, &header->memorySize, sizeof(header->memorySize)) && put(file, &header->dataOffset, sizeof(header->dataOffset));
+}
+
+static bool takeHeader(FILE* file, struct CheckpointHeader* header) {
+    return take(file, &header->magic, sizeof(header->magic)) && take(file, &header->version, sizeof(header->version)) &&
+           take(file, &header->engine, sizeof(header->engine)) && take(file, &header->fingerprint, sizeof(header->fingerprint)) &&
+           take(file, &header->memorySize, sizeof(header->memorySize)) && take(file, &header->dataOffset, sizeof(header->dataOffset));
+}
+
+/* The non-zero words of the resident pages, counted first so the reader knows how many follow */
+static bool putMemory(FILE* file, struct Memory* memory) {
+    uint64_t wordCount = 0;
+    int pageCount;
+    const uint32_t* pages = residentPages(memory, &pageCount);
+
+    for (int p = 0; p < pageCount; p++) {
+        const int* words = lookupPage(memory, pages[p] << PAGE_SHIFT);
+        for (uint32_t offset = 0; offset < PAGE_WORDS; offset++)
+            wordCount += words[offset] != 0;
+    }
+    if (!put(file, &wordCount, sizeof(wordCount))) return false;
+    for (int p = 0; p < pageCount; p++) {
+        const int* words = lookupPage(memory, pages[p] << PAGE_SHIFT);
+        for (uint32_t offset = 0; offset < PAGE_WORDS; offset++) {
+            uint32_t address = (pages[p] << PAGE_SHIFT) + offset;
+            int32_t value = words[offset];
+            if (value != 0 && !(put(file, &address, sizeof(address)) && put(file, &value, sizeof(value)))) return false;
+        }
+    }
+    return true;
+}
+
+static bool takeMemory(FILE* file, struct Memory* memory) {
+    uint64_t wordCount;
+
+    if (!take(file, &wordCount, sizeof(wordCount))) return false;
+    for (uint64_t i = 0; i < wordCount; i++) {
+        uint32_t address;
+        int32_t value;
+        if (!take(file, &address, sizeof(address)) || !take(file, &value, sizeof(value))) return false;
+        if (address >= memory->size) return false;
+        writeMemory(memory, address, value);
+    }
+    return true;
+}
+
+bool saveCheckpoint(struct Cpu* cpu, enum CheckpointEngine engine, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error in opening file: %s\n", path);
+        return false;
+    }
+
+    struct CheckpointHeader header = { CHECKPOINT_MAGIC, CHECKPOINT_VERSION, engine, configurationFingerprint(cpu),
+                                       cpu->memory.size, cpu->memory.dataOffset };
+    int32_t programCounter = cpu->programCounter, lineCount = cpu->lineCount;
+    bool ok = putHeader(file, &header) && put(file, &programCounter, sizeof(programCounter)) &&
+              put(file, &lineCount, sizeof(lineCount)) && put(file, cpu->registers, sizeof(cpu->registers)) &&
+              putMemory(file, &cpu->memory) && (engine == CHECKPOINT_FUNCTIONAL || putEngine(file, cpu, engine));
+    if (fclose(file) != 0) ok = false;
+    if (!ok) printf("Error in writing checkpoint: %s\n", path);
+    return ok;
+}
+
+bool restoreCheckpoint(struct Cpu* cpu, enum CheckpointEngine engine, const char* path) {
+    struct CheckpointHeader header;
+    int32_t programCounter, lineCount;
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        printf("Error in opening file: %s\n", path);
+        return false;
+    }
+    if (!takeHeader(file, &header) || header.magic != CHECKPOINT_MAGIC) {
+        printf("Not a checkpoint: %s\n", path);
+        fclose(file);
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        printf("%s: checkpoint version %u, expected %d\n", path, header.version, CHECKPOINT_VERSION);
+        fclose(file);
+        return false;
+    }
+    if (header.dataOffset <= 0 || header.memorySize <= header.dataOffset || header.memorySize > MAX_MEMORY_WORDS) {
+        printf("Truncated or corrupt checkpoint: %s\n", path);
+        fclose(file);
+        return false;
+    }
+    if (header.engine != CHECKPOINT_FUNCTIONAL && header.engine != (uint32_t)engine) {
+        printf("%s was saved in the %s, with instructions in flight, and resumes only there\n", path,
+               checkpointEngineName(header.engine));
+        fclose(file);
+        return false;
+    }
+    if (header.engine != CHECKPOINT_FUNCTIONAL && header.fingerprint != configurationFingerprint(cpu)) {
+        printf("%s was saved with another pipeline, out-of-order, predictor or memory hierarchy configuration\n", path);
+        fclose(file);
+        return false;
+    }
+
+    initMemory(&cpu->memory, header.dataOffset, header.memorySize - header.dataOffset);
+    resetProcessor(cpu);
+    bool ok = take(file, &programCounter, sizeof(programCounter)) && take(file, &lineCount, sizeof(lineCount)) &&
+              take(file, cpu->registers, sizeof(cpu->registers)) && takeMemory(file, &cpu->memory) &&
+              (header.engine == CHECKPOINT_FUNCTIONAL || takeEngine(file, cpu, engine));
+    fclose(file);
+    // The predecode table covers [0, lineCount) of the instruction region. A functional checkpoint is
+    // only saved with the PC inside the program; an engine one may hold a wrong-path PC, which fetch
+    // checks against the program before using.
+    ok = ok && lineCount >= 0 && lineCount <= header.dataOffset &&
+         (header.engine != CHECKPOINT_FUNCTIONAL || (programCounter >= 0 && programCounter < lineCount));
+    if (!ok) {
+        printf("Truncated or corrupt checkpoint: %s\n", path);
+        return false;
+    }
+    cpu->programCounter = programCounter;
+    cpu->lineCount = lineCount;
+    buildPredecodeTable(&cpu->predecode, &cpu->memory, cpu->lineCount);
+    return true;
+}
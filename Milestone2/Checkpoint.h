@@ -0,0 +1,32 @@
+#pragma once
+#include "Cpu.h"
+#include <stdbool.h>
+
+#define CHECKPOINT_MAGIC 0x43534143u // "CASC"
+#define CHECKPOINT_VERSION 1
+
+/* The engine a checkpoint was taken in. A functional checkpoint is the architectural state alone and
+   resumes in any engine, cold: caches, predictor and counters start from reset. A pipeline or
+   out-of-order checkpoint also holds everything in flight and resumes only in the same engine with the
+   same configuration, continuing the run exactly. */
+enum CheckpointEngine { CHECKPOINT_FUNCTIONAL, CHECKPOINT_PIPELINE, CHECKPOINT_OUT_OF_ORDER };
+
+/* File layout, host byte order; the engine section is the simulator's own structures, so only the same
+   build reads it back:
+   header:  uint32 magic, uint32 version, uint32 engine, uint64 configuration fingerprint,
+            int64 memory size, int32 dataOffset
+   state:   int32 programCounter, int32 lineCount, int32 registers[REGISTER_COUNT],
+            uint64 wordCount, wordCount x { uint32 address, int32 value }, the non-zero memory words
+   engine:  pipeline and out-of-order only: int32 cycle, the counters, the branch predictor, the
+            pipeline or the out-of-order core, for the I-cache, D-cache and L2 their lines, PLRU bits,
+            replacement state and MSHRs, the DRAM banks and the prefetcher's table */
+
+/* Returns false, having printed why, if the file cannot be written */
+bool saveCheckpoint(struct Cpu* cpu, enum CheckpointEngine engine, const char* path);
+
+/* Replaces the program, memory and processor state with the checkpoint's, for a run in the given engine.
+   cpu must already be configured for it. Returns false, having printed why, if the file cannot be read
+   or was saved by another engine or configuration than a non-functional checkpoint needs. */
+bool restoreCheckpoint(struct Cpu* cpu, enum CheckpointEngine engine, const char* path);
+
+const char* checkpointEngineName(enum CheckpointEngine engine);
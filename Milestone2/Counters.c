@@ -0,0 +1,233 @@
+#include "Counters.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* opcodeMnemonics[OPCODE_COUNT] = {
+    "ADD", "SUB", "MULI", "ADDI", "BNE", "ANDI", "ORI", "J",
+    "SLL", "SRL", "LW", "SW", "OP12", "OP13", "OP14", "OP15"
+};
+
+const char* stallCauseName(enum StallCause cause) {
+    switch (cause) {
+        case STALL_FETCH_SLOT:        return "fetchSlot";
+        case STALL_DATA_HAZARD:       return "dataHazard";
+        case STALL_LOAD_USE:          return "loadUse";
+        case STALL_EXECUTE_LATENCY:   return "executeLatency";
+        case STALL_UNIT_LATENCY:      return "unitLatency";
+        case STALL_INSTRUCTION_CACHE: return "instructionCache";
+        case STALL_DATA_CACHE:        return "dataCache";
+        case STALL_STORE_BUFFER:      return "storeBuffer";
+        default:                      return "unknown";
+    }
+}
+
+const char* issueLimitName(enum IssueLimit limit) {
+    switch (limit) {
+        case ISSUE_LIMIT_DEPENDENCE: return "dependence";
+        case ISSUE_LIMIT_MEMORY:     return "memoryOp";
+        case ISSUE_LIMIT_BRANCH:     return "branch";
+        default:                     return "unknown";
+    }
+}
+
+const char* dispatchStallName(enum DispatchStall stall) {
+    switch (stall) {
+        case DISPATCH_STALL_REORDER_BUFFER: return "robFull";
+        case DISPATCH_STALL_STATIONS:       return "stationsFull";
+        case DISPATCH_STALL_LOAD_STORE:     return "loadStoreQueueFull";
+        default:                            return "unknown";
+    }
+}
+
+static double cyclesPerInstruction(const struct PerfCounters* counters) {
+    return counters->instructionsRetired > 0 ? (double)counters->cycles / counters->instructionsRetired : 0.0;
+}
+
+static double instructionsPerCycle(const struct PerfCounters* counters) {
+    return counters->cycles > 0 ? (double)counters->instructionsRetired / counters->cycles : 0.0;
+}
+
+/* Share of BNEs and Js whose next PC IF predicted correctly */
+static double predictionAccuracy(const struct PerfCounters* counters) {
+    long long resolved = counters->branches + counters->jumps;
+    return resolved > 0 ? 1.0 - (double)(counters->flushesBne + counters->flushesJump) / resolved : 0.0;
+}
+
+long long cacheAccesses(const struct CacheCounters* cache) {
+    return cache->reads + cache->writes;
+}
+
+static long long cacheMisses(const struct CacheCounters* cache) {
+    return cache->readMisses + cache->writeMisses;
+}
+
+double cacheHitRate(const struct CacheCounters* cache) {
+    return cacheAccesses(cache) > 0 ? 1.0 - (double)cacheMisses(cache) / cacheAccesses(cache) : 0.0;
+}
+
+double cacheMpki(const struct PerfCounters* counters, const struct CacheCounters* cache) {
+    return counters->instructionsRetired > 0 ? 1000.0 * cacheMisses(cache) / counters->instructionsRetired : 0.0;
+}
+
+static void writeCacheJson(const struct PerfCounters* counters, const struct CacheCounters* cache, const char* name, FILE* file) {
+    fprintf(file, "  \"%s\": {\"reads\": %lld, \"writes\": %lld, \"readMisses\": %lld, \"writeMisses\": %lld, "
+            "\"hitRate\": %.4f, \"mpki\": %.4f, \"writebacks\": %lld, \"writesThrough\": %lld, \"mshrMerges\": %lld, "
+            "\"mshrWaitCycles\": %lld}",
+            name, cache->reads, cache->writes, cache->readMisses, cache->writeMisses, cacheHitRate(cache),
+            cacheMpki(counters, cache), cache->writebacks, cache->writesThrough, cache->mshrMerges, cache->mshrWaitCycles);
+}
+
+static void writeCacheCsv(const struct PerfCounters* counters, const struct CacheCounters* cache, const char* name, FILE* file) {
+    fprintf(file, "%s.reads,%lld\n", name, cache->reads);
+    fprintf(file, "%s.writes,%lld\n", name, cache->writes);
+    fprintf(file, "%s.readMisses,%lld\n", name, cache->readMisses);
+    fprintf(file, "%s.writeMisses,%lld\n", name, cache->writeMisses);
+    fprintf(file, "%s.hitRate,%.4f\n", name, cacheHitRate(cache));
+    fprintf(file, "%s.mpki,%.4f\n", name, cacheMpki(counters, cache));
+    fprintf(file, "%s.writebacks,%lld\n", name, cache->writebacks);
+    fprintf(file, "%s.writesThrough,%lld\n", name, cache->writesThrough);
+    fprintf(file, "%s.mshrMerges,%lld\n", name, cache->mshrMerges);
+    fprintf(file, "%s.mshrWaitCycles,%lld\n", name, cache->mshrWaitCycles);
+}
+
+double prefetchAccuracy(const struct PerfCounters* counters) {
+    const struct PrefetchCounters* prefetch = &counters->prefetch;
+    return prefetch->issued > 0 ? (double)prefetch->useful / prefetch->issued : 0.0;
+}
+
+double prefetchCoverage(const struct PerfCounters* counters) {
+    long long missesWithout = counters->prefetch.useful + cacheMisses(&counters->dataCache);
+    return missesWithout > 0 ? (double)counters->prefetch.useful / missesWithout : 0.0;
+}
+
+double prefetchTimeliness(const struct PerfCounters* counters) {
+    const struct PrefetchCounters* prefetch = &counters->prefetch;
+    return prefetch->useful > 0 ? 1.0 - (double)prefetch->late / prefetch->useful : 0.0;
+}
+
+double dramRowHitRate(const struct DramCounters* dram) {
+    long long accesses = dram->reads + dram->writes;
+    return accesses > 0 ? (double)dram->rowHits / accesses : 0.0;
+}
+
+static void writeJson(const struct PerfCounters* counters, FILE* file) {
+    fprintf(file, "{\n");
+    fprintf(file, "  \"cycles\": %lld,\n", counters->cycles);
+    fprintf(file, "  \"instructionsRetired\": %lld,\n", counters->instructionsRetired);
+    fprintf(file, "  \"cpi\": %.4f,\n", cyclesPerInstruction(counters));
+    fprintf(file, "  \"ipc\": %.4f,\n", instructionsPerCycle(counters));
+
+    fprintf(file, "  \"retiredByOpcode\": {");
+    for (int opcode = 0, printed = 0; opcode < OPCODE_COUNT; opcode++) {
+        if (opcode >= 12 && counters->retiredByOpcode[opcode] == 0) continue; // Unassigned opcodes
+        fprintf(file, "%s\"%s\": %lld", printed++ ? ", " : "", opcodeMnemonics[opcode], counters->retiredByOpcode[opcode]);
+    }
+    fprintf(file, "},\n");
+
+    fprintf(file, "  \"stallCycles\": {");
+    for (int cause = 0; cause < STALL_CAUSE_COUNT; cause++)
+        fprintf(file, "%s\"%s\": %lld", cause ? ", " : "", stallCauseName(cause), counters->stallCycles[cause]);
+    fprintf(file, "},\n");
+
+    fprintf(file, "  \"branches\": {\"BNE\": %lld, \"J\": %lld},\n", counters->branches, counters->jumps);
+    fprintf(file, "  \"flushes\": {\"BNE\": %lld, \"J\": %lld},\n", counters->flushesBne, counters->flushesJump);
+    fprintf(file, "  \"predictionAccuracy\": %.4f,\n", predictionAccuracy(counters));
+    fprintf(file, "  \"squashedInstructions\": %lld,\n", counters->squashedInstructions);
+    fprintf(file, "  \"forwardedOperands\": %lld,\n", counters->forwardedOperands);
+    fprintf(file, "  \"loads\": %lld,\n", counters->loads);
+    fprintf(file, "  \"stores\": %lld,\n", counters->stores);
+
+    fprintf(file, "  \"issueGroups\": {");
+    for (int size = 1; size <= MAX_ISSUE_WIDTH; size++)
+        fprintf(file, "%s\"%d\": %lld", size > 1 ? ", " : "", size, counters->issueGroups[size]);
+    fprintf(file, "},\n");
+
+    fprintf(file, "  \"issueLimits\": {");
+    for (int limit = 0; limit < ISSUE_LIMIT_COUNT; limit++)
+        fprintf(file, "%s\"%s\": %lld", limit ? ", " : "", issueLimitName(limit), counters->issueLimits[limit]);
+    fprintf(file, "},\n");
+
+    fprintf(file, "  \"dispatchStalls\": {");
+    for (int stall = 0; stall < DISPATCH_STALL_COUNT; stall++)
+        fprintf(file, "%s\"%s\": %lld", stall ? ", " : "", dispatchStallName(stall), counters->dispatchStalls[stall]);
+    fprintf(file, "},\n");
+    fprintf(file, "  \"storeForwards\": %lld,\n", counters->storeForwards);
+    writeCacheJson(counters, &counters->instructionCache, "instructionCache", file);
+    fprintf(file, ",\n");
+    writeCacheJson(counters, &counters->dataCache, "dataCache", file);
+    fprintf(file, ",\n");
+    writeCacheJson(counters, &counters->l2Cache, "l2Cache", file);
+    fprintf(file, ",\n");
+    fprintf(file, "  \"prefetch\": {\"issued\": %lld, \"dropped\": %lld, \"useful\": %lld, \"late\": %lld, \"unused\": %lld, "
+            "\"accuracy\": %.4f, \"coverage\": %.4f, \"timeliness\": %.4f},\n", counters->prefetch.issued, counters->prefetch.dropped,
+            counters->prefetch.useful, counters->prefetch.late, counters->prefetch.unused, prefetchAccuracy(counters),
+            prefetchCoverage(counters), prefetchTimeliness(counters));
+    fprintf(file, "  \"dram\": {\"reads\": %lld, \"writes\": %lld, \"rowHits\": %lld, \"rowMisses\": %lld, \"rowConflicts\": %lld, "
+            "\"rowHitRate\": %.4f, \"bankWaitCycles\": %lld}\n", counters->dram.reads, counters->dram.writes, counters->dram.rowHits,
+            counters->dram.rowMisses, counters->dram.rowConflicts, dramRowHitRate(&counters->dram), counters->dram.bankWaitCycles);
+    fprintf(file, "}\n");
+}
+
+static void writeCsv(const struct PerfCounters* counters, FILE* file) {
+    fprintf(file, "counter,value\n");
+    fprintf(file, "cycles,%lld\n", counters->cycles);
+    fprintf(file, "instructionsRetired,%lld\n", counters->instructionsRetired);
+    fprintf(file, "cpi,%.4f\n", cyclesPerInstruction(counters));
+    fprintf(file, "ipc,%.4f\n", instructionsPerCycle(counters));
+    for (int opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        if (opcode >= 12 && counters->retiredByOpcode[opcode] == 0) continue;
+        fprintf(file, "retiredByOpcode.%s,%lld\n", opcodeMnemonics[opcode], counters->retiredByOpcode[opcode]);
+    }
+    for (int cause = 0; cause < STALL_CAUSE_COUNT; cause++)
+        fprintf(file, "stallCycles.%s,%lld\n", stallCauseName(cause), counters->stallCycles[cause]);
+    fprintf(file, "branches.BNE,%lld\n", counters->branches);
+    fprintf(file, "branches.J,%lld\n", counters->jumps);
+    fprintf(file, "flushes.BNE,%lld\n", counters->flushesBne);
+    fprintf(file, "flushes.J,%lld\n", counters->flushesJump);
+    fprintf(file, "predictionAccuracy,%.4f\n", predictionAccuracy(counters));
+    fprintf(file, "squashedInstructions,%lld\n", counters->squashedInstructions);
+    fprintf(file, "forwardedOperands,%lld\n", counters->forwardedOperands);
+    fprintf(file, "loads,%lld\n", counters->loads);
+    fprintf(file, "stores,%lld\n", counters->stores);
+    for (int size = 1; size <= MAX_ISSUE_WIDTH; size++)
+        fprintf(file, "issueGroups.%d,%lld\n", size, counters->issueGroups[size]);
+    for (int limit = 0; limit < ISSUE_LIMIT_COUNT; limit++)
+        fprintf(file, "issueLimits.%s,%lld\n", issueLimitName(limit), counters->issueLimits[limit]);
+    for (int stall = 0; stall < DISPATCH_STALL_COUNT; stall++)
+        fprintf(file, "dispatchStalls.%s,%lld\n", dispatchStallName(stall), counters->dispatchStalls[stall]);
+    fprintf(file, "storeForwards,%lld\n", counters->storeForwards);
+    writeCacheCsv(counters, &counters->instructionCache, "instructionCache", file);
+    writeCacheCsv(counters, &counters->dataCache, "dataCache", file);
+    writeCacheCsv(counters, &counters->l2Cache, "l2Cache", file);
+    fprintf(file, "prefetch.issued,%lld\n", counters->prefetch.issued);
+    fprintf(file, "prefetch.dropped,%lld\n", counters->prefetch.dropped);
+    fprintf(file, "prefetch.useful,%lld\n", counters->prefetch.useful);
+    fprintf(file, "prefetch.late,%lld\n", counters->prefetch.late);
+    fprintf(file, "prefetch.unused,%lld\n", counters->prefetch.unused);
+    fprintf(file, "prefetch.accuracy,%.4f\n", prefetchAccuracy(counters));
+    fprintf(file, "prefetch.coverage,%.4f\n", prefetchCoverage(counters));
+    fprintf(file, "prefetch.timeliness,%.4f\n", prefetchTimeliness(counters));
+    fprintf(file, "dram.reads,%lld\n", counters->dram.reads);
+    fprintf(file, "dram.writes,%lld\n", counters->dram.writes);
+    fprintf(file, "dram.rowHits,%lld\n", counters->dram.rowHits);
+    fprintf(file, "dram.rowMisses,%lld\n", counters->dram.rowMisses);
+    fprintf(file, "dram.rowConflicts,%lld\n", counters->dram.rowConflicts);
+    fprintf(file, "dram.rowHitRate,%.4f\n", dramRowHitRate(&counters->dram));
+    fprintf(file, "dram.bankWaitCycles,%lld\n", counters->dram.bankWaitCycles);
+}
+
+bool writeCountersReport(const struct PerfCounters* counters, const char* path) {
+    size_t length = strlen(path);
+    FILE* file = fopen(path, "w");
+
+    if (file == NULL) {
+        printf("Error in opening file: %s\n", path);
+        return false;
+    }
+    if (length >= 4 && strcmp(path + length - 4, ".csv") == 0)
+        writeCsv(counters, file);
+    else
+        writeJson(counters, file);
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "Simulator.h"
+#include <stdbool.h>
+
+#define OPCODE_COUNT 16
+
+/* Reasons a stage left a cycle empty */
+enum StallCause {
+    STALL_FETCH_SLOT,        // IF only gets every other cycle through a shared memory port
+    STALL_DATA_HAZARD,       // ID waiting for a source register to be written back, with forwarding off
+    STALL_LOAD_USE,          // EX waiting for a loaded value to reach the WB latch
+    STALL_EXECUTE_LATENCY,   // EX waiting for an ALU result still in a later EX stage, in deeper pipelines
+    STALL_UNIT_LATENCY,      // A multi-cycle unit holding its group: unpipelined and busy, or a result not back for WB
+    STALL_INSTRUCTION_CACHE, // IF waiting on the I-cache beyond one cycle
+    STALL_DATA_CACHE,        // MEM waiting on the D-cache beyond one cycle; loads, for the out-of-order core
+    STALL_STORE_BUFFER,      // A SW in the last MEM stage waiting for a free store buffer entry
+    STALL_CAUSE_COUNT
+};
+
+/* Why ID issued fewer instructions than it held in a cycle */
+enum IssueLimit {
+    ISSUE_LIMIT_DEPENDENCE, // A source written by an older instruction in the group, or not written back yet
+    ISSUE_LIMIT_MEMORY,     // A second LW/SW, there is one data port
+    ISSUE_LIMIT_BRANCH,     // Instructions after a BNE or J, which ends its group
+    ISSUE_LIMIT_COUNT
+};
+
+/* Why the out-of-order core's dispatch left instructions in the fetch queue in a cycle */
+enum DispatchStall {
+    DISPATCH_STALL_REORDER_BUFFER, // Reorder buffer full
+    DISPATCH_STALL_STATIONS,       // No free reservation station for the instruction's unit
+    DISPATCH_STALL_LOAD_STORE,     // Load/store queue full
+    DISPATCH_STALL_COUNT
+};
+
+/* Accesses to one cache, all zero while it is disabled */
+struct CacheCounters {
+    long long reads, writes;
+    long long readMisses, writeMisses;
+    long long writebacks;    // Dirty lines evicted, by a write-back cache
+    long long writesThrough; // Stores passed on to memory, by a write-through cache
+    long long mshrMerges;    // Accesses to a line whose miss was still outstanding
+    long long mshrWaitCycles; // Misses waiting for a free MSHR
+};
+
+/* What became of the lines the data prefetcher asked for */
+struct PrefetchCounters {
+    long long issued;  // Lines filled, not already cached
+    long long dropped; // Not issued, every MSHR busy with a miss
+    long long useful;  // Used by a demand access
+    long long late;    // Of those, still being filled when used
+    long long unused;  // Evicted without a use
+};
+
+struct DramCounters {
+    long long reads, writes;
+    long long rowHits;
+    long long rowMisses;    // Row activated in an idle bank
+    long long rowConflicts; // Another row open, precharged first
+    long long bankWaitCycles; // Accesses waiting for their bank to finish an earlier one
+};
+
+/* Event counts gathered by the pipeline stages, reset with the processor */
+struct PerfCounters {
+    long long cycles;
+    long long instructionsRetired;
+    long long retiredByOpcode[OPCODE_COUNT];
+    long long stallCycles[STALL_CAUSE_COUNT];
+    long long branches;    // BNEs executed
+    long long jumps;
+    long long flushesBne;  // Mispredicted, IF/ID refetched from the resolved PC
+    long long flushesJump;
+    long long squashedInstructions; // Words in IF/ID discarded by those flushes
+    long long forwardedOperands;    // Operands taken from a bypass path instead of the register file
+    long long loads;
+    long long stores;
+    long long issueGroups[MAX_ISSUE_WIDTH + 1]; // Groups ID sent to EX, by size
+    long long issueLimits[ISSUE_LIMIT_COUNT];   // Groups split by the pairing rules, by reason
+    long long dispatchStalls[DISPATCH_STALL_COUNT]; // Out-of-order core only
+    long long storeForwards; // Loads that took their value from an older store still in flight, or in the store buffer
+    struct CacheCounters instructionCache, dataCache, l2Cache;
+    struct PrefetchCounters prefetch;
+    struct DramCounters dram;
+};
+
+const char* stallCauseName(enum StallCause cause);
+const char* issueLimitName(enum IssueLimit limit);
+const char* dispatchStallName(enum DispatchStall stall);
+
+long long cacheAccesses(const struct CacheCounters* cache);
+double cacheHitRate(const struct CacheCounters* cache);
+double cacheMpki(const struct PerfCounters* counters, const struct CacheCounters* cache); // Misses per thousand retired instructions
+/* Share of issued prefetches used, of the D-cache misses they saved the demand accesses, and of the used
+   ones that arrived in time */
+double prefetchAccuracy(const struct PerfCounters* counters);
+double prefetchCoverage(const struct PerfCounters* counters);
+double prefetchTimeliness(const struct PerfCounters* counters);
+double dramRowHitRate(const struct DramCounters* dram);
+
+/* Writes the counters as a JSON object, or as "counter,value" CSV rows when path ends in .csv */
+bool writeCountersReport(const struct PerfCounters* counters, const char* path);
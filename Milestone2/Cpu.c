@@ -0,0 +1,231 @@
+#include "Cpu.h"
+#include "Assembler.h"
+#include "FileReader.h"
+#include "LatencyTable.h"
+#include "OutOfOrder.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void initCpu(struct Cpu* cpu, int instructionWords, long long dataWords) {
+    memset(cpu, 0, sizeof(*cpu));
+    initBranchPredictor(&cpu->predictor, DEFAULT_PREDICTOR);
+    cpu->pipelineDepth = MIN_PIPELINE_DEPTH;
+    cpu->memoryPorts = MEMORY_SHARED_PORT;
+    cpu->issueWidth = 1;
+    initOutOfOrderConfig(&cpu->outOfOrderConfig);
+    initUnitTimings(cpu->unitTimings, false);
+    cpu->resolveStage = RESOLVE_IN_EXECUTE;
+    cpu->forwarding = true;
+    initMemory(&cpu->memory, instructionWords, dataWords);
+    struct MemoryHierarchyConfig memoryHierarchy;
+    initMemoryHierarchyConfig(&memoryHierarchy);
+    configureMemoryHierarchy(cpu, &memoryHierarchy);
+    resetProcessor(cpu);
+}
+
+void configureMemoryHierarchy(struct Cpu* cpu, const struct MemoryHierarchyConfig* config) {
+    struct Dram* dram = config->dram.enabled ? &cpu->dram : NULL;
+    struct Cache* l2Cache = config->l2Cache.enabled ? &cpu->l2Cache : NULL;
+
+    configureDram(&cpu->dram, &config->dram, &cpu->counters.dram);
+    configureCache(&cpu->l2Cache, &config->l2Cache, &cpu->counters.l2Cache, NULL, dram);
+    configureCache(&cpu->instructionCache, &config->instructionCache, &cpu->counters.instructionCache, l2Cache, dram);
+    configureCache(&cpu->dataCache, &config->dataCache, &cpu->counters.dataCache, l2Cache, dram);
+    configurePrefetcher(&cpu->prefetcher, &config->prefetcher, config->dataCache.lineWords, &cpu->counters.prefetch);
+    if (config->dataCache.enabled && config->prefetcher.kind != PREFETCH_NONE) cpu->dataCache.prefetcher = &cpu->prefetcher;
+}
+
+void freeCpu(struct Cpu* cpu) {
+    freeMemory(&cpu->memory);
+    freePredecodeTable(&cpu->predecode);
+    freeCache(&cpu->instructionCache);
+    freeCache(&cpu->dataCache);
+    freeCache(&cpu->l2Cache);
+    freePrefetcher(&cpu->prefetcher);
+}
+
+/* Parsing and Loading Methods */
+
+/* Records where each non-empty line of the mapped file starts, without copying any of it */
+static struct SourceLine* splitSourceLines(const struct MappedFile* source, int* sourceLineCount) {
+    const char* cursor = source->data;
+    const char* fileEnd = cursor + source->size;
+
+    int newlineCount = 0;
+    for (const char* c = cursor; c < fileEnd && (c = memchr(c, '\n', fileEnd - c)) != NULL; c++)
+        newlineCount++;
+    struct SourceLine* lines = malloc((newlineCount + 1) * sizeof(struct SourceLine));
+
+    *sourceLineCount = 0;
+    for (int number = 1; cursor < fileEnd; number++) {
+        const char* lineEnd = memchr(cursor, '\n', fileEnd - cursor);
+        if (lineEnd == NULL) lineEnd = fileEnd;
+
+        int length = lineEnd - cursor;
+        // Remove trailing \r if it exists
+        if (length > 0 && cursor[length - 1] == '\r') length--;
+
+        bool blank = true;
+        for (int i = 0; i < length && blank; i++)
+            blank = cursor[i] == ' ' || cursor[i] == '\t';
+
+        if (!blank) {
+            lines[*sourceLineCount].text = cursor;
+            lines[*sourceLineCount].length = length;
+            lines[*sourceLineCount].number = number;
+            (*sourceLineCount)++;
+        }
+        cursor = lineEnd + 1;
+    }
+    return lines;
+}
+
+bool loadProgram(struct Cpu* cpu, const char* filepath) {
+    struct MappedFile source;
+    int sourceLineCount;
+
+    initMemory(&cpu->memory, cpu->memory.dataOffset, cpu->memory.size - cpu->memory.dataOffset);
+    cpu->lineCount = 0;
+    resetProcessor(cpu);
+    if (!mapFile(filepath, &source)) return false;
+
+    // The line views point into the mapping, which is no longer needed once everything is encoded
+    struct SourceLine* lines = splitSourceLines(&source, &sourceLineCount);
+    int instructionCount = assembleProgram(lines, sourceLineCount, &cpu->memory);
+    free(lines);
+    unmapFile(&source);
+
+    cpu->lineCount = instructionCount > 0 ? instructionCount : 0;
+    buildPredecodeTable(&cpu->predecode, &cpu->memory, cpu->lineCount);
+    return instructionCount >= 0;
+}
+
+void resetProcessor(struct Cpu* cpu) {
+    memset(cpu->registers, 0, sizeof(cpu->registers));
+    memset(&cpu->pipeline, 0, sizeof(cpu->pipeline));
+    cpu->pipeline.fetchReady = true;
+    resetOutOfOrderCore(&cpu->outOfOrder);
+    cpu->programCounter = 0;
+    cpu->cycle = 1;
+    memset(&cpu->counters, 0, sizeof(cpu->counters));
+    resetBranchPredictor(&cpu->predictor);
+    resetCache(&cpu->instructionCache);
+    resetCache(&cpu->dataCache);
+    resetCache(&cpu->l2Cache);
+    resetDram(&cpu->dram);
+    resetPrefetcher(&cpu->prefetcher);
+}
+
+bool runLimitReached(const struct Cpu* cpu, long long cycleLimit, long long instructionLimit) {
+    return (cycleLimit > 0 && cpu->counters.cycles >= cycleLimit) ||
+           (instructionLimit > 0 && cpu->counters.instructionsRetired >= instructionLimit);
+}
+
+static uint64_t hashWord(uint64_t hash, uint32_t word) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (word >> (8 * i)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void reportMemoryAccessError(int pc, int address) {
+    TRACE_SUMMARY("Memory access error: address %d is out of bounds at PC %d\n", address, pc);
+}
+
+uint64_t hashCpuState(struct Cpu* cpu) {
+    uint64_t hash = 14695981039346656037ull;
+    int pageCount;
+
+    for (int i = 0; i < REGISTER_COUNT; i++)
+        hash = hashWord(hash, cpu->registers[i]);
+
+    const uint32_t* pages = residentPages(&cpu->memory, &pageCount);
+    for (int p = 0; p < pageCount; p++) {
+        const int* words = lookupPage(&cpu->memory, pages[p] << PAGE_SHIFT);
+        for (uint32_t offset = 0; offset < PAGE_WORDS; offset++) {
+            if (words[offset] == 0) continue;
+            hash = hashWord(hash, (pages[p] << PAGE_SHIFT) + offset);
+            hash = hashWord(hash, words[offset]);
+        }
+    }
+    return hash;
+}
+
+void printRInstruction(const struct DecodedInstructionFields* fields);
+void printJInstruction(const struct DecodedInstructionFields* fields);
+void printIInstruction(const struct DecodedInstructionFields* fields);
+
+void printMainMemory(struct Cpu* cpu) {
+
+    for (int i = 0; i < cpu->memory.dataOffset; i++) {
+        const struct DecodedInstructionFields* fields = predecodedFor(&cpu->predecode, i, readMemory(&cpu->memory, i));
+        int opcode = fields->opcode;
+        if (opcode == 0 || opcode == 1 || opcode == 8 || opcode == 9) {
+            printRInstruction(fields);
+        } else if (opcode == 7) {
+            printJInstruction(fields);
+        }else {
+            printIInstruction(fields);
+        }
+    }
+
+}
+
+void printMainMemoryMinimal(struct Cpu* cpu){
+    printf("----------------------------\nMain Memory (non-zero):\n");
+    // Only resident pages can hold non-zero words
+    int pageCount;
+    const uint32_t* pages = residentPages(&cpu->memory, &pageCount);
+    for (int p = 0; p < pageCount; p++){
+        const int* words = lookupPage(&cpu->memory, pages[p] << PAGE_SHIFT);
+        for (uint32_t offset = 0; offset < PAGE_WORDS; offset++){
+            uint32_t i = (pages[p] << PAGE_SHIFT) + offset;
+            if (words[offset] == 0) continue;
+            if (i < (uint32_t)cpu->memory.dataOffset){
+                printf("Index: %u, Value: 0x%08X, Instruction Mnemonic: %s\n",i, words[offset], getInstructionTextAt(cpu, i, words[offset]));
+            } else {
+                printf("Index: %u, Value: %d\n",i, words[offset]);
+            }
+        }
+    }
+}
+
+void printRegisters(const struct Cpu* cpu) {
+
+    printf("----------------------\nRegisters:\n");
+    for (int i =0; i < REGISTER_COUNT; i++) {
+        printf("R%d: %d: ", i, cpu->registers[i]);
+        if ((i+1) % 4 != 0) printf(" ");
+        else printf("\n");
+    }
+
+}
+
+void printRInstruction(const struct DecodedInstructionFields* fields) {
+    printf("%d %d %d %d %d\n", fields->opcode, fields->r1, fields->r2, fields->r3, fields->shamt);
+
+}
+
+void printJInstruction(const struct DecodedInstructionFields* fields) {
+    printf("%d %d \n", fields->opcode, fields->address);
+}
+
+void printIInstruction(const struct DecodedInstructionFields* fields) {
+    printf("%d %d %d %d \n", fields->opcode, fields->r1, fields->r2, fields->immediate);
+}
+
+/* Disassembles a word fetched from pc, reading the predecoded table */
+char* getInstructionTextAt(struct Cpu* cpu, int pc, int instruction) {
+    static char instructionText[50];
+
+    if (instruction == 0) {
+        strcpy(instructionText, "-");
+        return instructionText;
+    }
+
+    disassembleInstruction(predecodedFor(&cpu->predecode, pc, instruction), instructionText);
+    return instructionText;
+}
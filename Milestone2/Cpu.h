@@ -0,0 +1,64 @@
+#pragma once
+#include "Simulator.h"
+#include "Memory.h"
+#include "Predecode.h"
+#include "Counters.h"
+#include "Cache.h"
+#include <stdint.h>
+
+/* One simulated processor and the program loaded into it. Every execution engine works on a Cpu
+   passed in explicitly, so independent instances can run side by side on separate threads. */
+struct Cpu {
+    int registers[REGISTER_COUNT];
+    int programCounter;
+    int lineCount; // Number of instructions in the loaded program
+    struct Memory memory;
+    struct Cache instructionCache, dataCache; // In front of memory for IF and MEM, timing only
+    struct Cache l2Cache; // Unified, behind both
+    struct Dram dram;
+    struct Prefetcher prefetcher; // Serving the D-cache
+    struct PredecodeTable predecode;
+    struct Pipeline pipeline;
+    int pipelineDepth; // Stages in the pipeline model, MIN_PIPELINE_DEPTH to MAX_PIPELINE_DEPTH
+    enum MemoryPorts memoryPorts;
+    int issueWidth; // Instructions fetched and issued per cycle, 1 to MAX_ISSUE_WIDTH
+    int storeBufferEntries; // Capacity of the pipeline's store buffer, 0 for SW to write memory in MEM
+    struct OutOfOrderCore outOfOrder; // State of the out-of-order engine, which replaces the pipeline when used
+    struct OutOfOrderConfig outOfOrderConfig;
+    struct UnitTiming unitTimings[UNIT_COUNT]; // Per opcode class, for the pipeline and the out-of-order core
+    struct BranchPredictor predictor;
+    enum ResolveStage resolveStage;
+    bool forwarding; // EX/MEM and MEM/WB bypass paths; off, ID waits for write-back
+    int cycle;
+    struct PerfCounters counters;
+};
+
+void initCpu(struct Cpu* cpu, int instructionWords, long long dataWords);
+void freeCpu(struct Cpu* cpu);
+
+/* Sets up the caches and the DRAM and connects each enabled level to the next enabled one below it, and
+   the prefetcher to the D-cache */
+void configureMemoryHierarchy(struct Cpu* cpu, const struct MemoryHierarchyConfig* config);
+
+/* Clears memory, then assembles the program file into it and predecodes it. Returns false if the file
+   cannot be read or does not assemble. */
+bool loadProgram(struct Cpu* cpu, const char* filepath);
+
+/* Puts the processor back in its reset state, leaving memory untouched */
+void resetProcessor(struct Cpu* cpu);
+
+/* Whether a timed run has reached cycleLimit cycles or retired instructionLimit instructions, as
+   counted in cpu->counters; a limit of 0 never does */
+bool runLimitReached(const struct Cpu* cpu, long long cycleLimit, long long instructionLimit);
+
+/* Reports a LW/SW at pc to an address outside memory, which leaves memory and its register untouched.
+   Called once per instruction as it executes; printed from --trace summary up. */
+void reportMemoryAccessError(int pc, int address);
+
+/* FNV-1a over the registers and every non-zero memory word with its address. Independent of timing,
+   so the pipeline and the functional mode agree on it for the same program. */
+uint64_t hashCpuState(struct Cpu* cpu);
+
+void printRegisters(const struct Cpu* cpu);
+void printMainMemoryMinimal(struct Cpu* cpu);
+char* getInstructionTextAt(struct Cpu* cpu, int pc, int instruction); // Static buffer, for tracing only
@@ -0,0 +1,96 @@
+#include "Dram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void initDramConfig(struct DramConfig* config) {
+    config->enabled = false;
+    config->banks = 8;
+    config->rowWords = 1024;
+    config->tCAS = 15;
+    config->tRCD = 15;
+    config->tRP = 15;
+}
+
+static int* settingField(struct DramConfig* config, const char* key, int* maximum, bool* powerOfTwo) {
+    *powerOfTwo = false;
+    *maximum = MAX_DRAM_TIMING;
+    if (strcmp(key, "tcas") == 0) return &config->tCAS;
+    if (strcmp(key, "trcd") == 0) return &config->tRCD;
+    if (strcmp(key, "trp") == 0) return &config->tRP;
+    *powerOfTwo = true;
+    *maximum = MAX_DRAM_BANKS;
+    if (strcmp(key, "banks") == 0) return &config->banks;
+    *maximum = MAX_DRAM_ROW_WORDS;
+    if (strcmp(key, "row") == 0) return &config->rowWords;
+    return NULL;
+}
+
+bool parseDramConfig(struct DramConfig* config, const char* settings) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    config->enabled = true;
+    if (strcmp(settings, "on") == 0) return true;
+    for (char* setting = strtok(buffer, ","); setting != NULL; setting = strtok(NULL, ",")) {
+        char* separator = strchr(setting, '=');
+        char* end;
+        int maximum;
+        bool powerOfTwo;
+
+        if (separator == NULL) {
+            printf("DRAM settings are key=value pairs: %s\n", setting);
+            return false;
+        }
+        *separator = '\0';
+        int* field = settingField(config, setting, &maximum, &powerOfTwo);
+        if (field == NULL) {
+            printf("Unknown DRAM setting: %s\n", setting);
+            return false;
+        }
+        long value = strtol(separator + 1, &end, 10);
+        if (*end != '\0' || value < 1 || value > maximum || (powerOfTwo && (value & (value - 1)) != 0)) {
+            printf("DRAM setting %s must be %s1 to %d: %s\n", setting, powerOfTwo ? "a power of two from " : "", maximum, separator + 1);
+            return false;
+        }
+        *field = (int)value;
+    }
+    return true;
+}
+
+void configureDram(struct Dram* dram, const struct DramConfig* config, struct DramCounters* counters) {
+    dram->config = *config;
+    dram->counters = counters;
+    dram->rowBits = 0;
+    while ((1 << dram->rowBits) < config->rowWords) dram->rowBits++;
+    resetDram(dram);
+}
+
+void resetDram(struct Dram* dram) {
+    memset(dram->banks, 0, sizeof(dram->banks));
+}
+
+int accessDram(struct Dram* dram, uint32_t address, bool write, int cycle) {
+    const struct DramConfig* config = &dram->config;
+    uint32_t row = address >> dram->rowBits;
+    struct DramBank* bank = &dram->banks[row & (config->banks - 1)];
+    int start = bank->readyCycle > cycle ? bank->readyCycle : cycle;
+    int latency = config->tCAS;
+
+    if (write) dram->counters->writes++;
+    else dram->counters->reads++;
+    dram->counters->bankWaitCycles += start - cycle;
+    if (bank->rowOpen && bank->row == row) {
+        dram->counters->rowHits++;
+    } else if (bank->rowOpen) {
+        dram->counters->rowConflicts++;
+        latency += config->tRP + config->tRCD;
+    } else {
+        dram->counters->rowMisses++;
+        latency += config->tRCD;
+    }
+    bank->rowOpen = true;
+    bank->row = row;
+    bank->readyCycle = start + latency;
+    return start + latency - cycle;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Counters.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_DRAM_BANKS 64
+#define MAX_DRAM_ROW_WORDS (1 << 16)
+#define MAX_DRAM_TIMING 1000
+
+/* Open-page DRAM behind the caches. Row r lives in bank r % banks, so a stream of lines stays in one
+   open row while neighbouring rows are served by other banks in parallel. Timings are in core cycles. */
+struct DramConfig {
+    bool enabled;
+    int banks;    // Power of two
+    int rowWords; // Power of two
+    int tCAS;     // Column access, all a row hit costs
+    int tRCD;     // Activating a row in an idle bank
+    int tRP;      // Precharging the open row first, on a row conflict
+};
+
+struct DramBank {
+    bool rowOpen;
+    uint32_t row;
+    int readyCycle; // Busy with an earlier access until then
+};
+
+struct Dram {
+    struct DramConfig config;
+    int rowBits;
+    struct DramBank banks[MAX_DRAM_BANKS];
+    struct DramCounters* counters;
+};
+
+/* Defaults: 8 banks of 1024-word rows, tCAS = tRCD = tRP = 15 cycles; disabled */
+void initDramConfig(struct DramConfig* config);
+
+/* Enables the DRAM and applies comma-separated key=value settings, or just enables it for "on". Keys:
+   banks, row, tcas, trcd and trp. Returns false, having printed why, on an unknown key or a value out of
+   range. */
+bool parseDramConfig(struct DramConfig* config, const char* settings);
+
+void configureDram(struct Dram* dram, const struct DramConfig* config, struct DramCounters* counters);
+void resetDram(struct Dram* dram); // Closes every row
+
+/* Cycles from cycle until the access to the word at address is served, waiting for its bank first */
+int accessDram(struct Dram* dram, uint32_t address, bool write, int cycle);
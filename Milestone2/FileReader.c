@@ -1,27 +1,102 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "FileReader.h"
 
-char* readFile(char* filepath) {
-	
-	FILE *file = fopen(filepath, "r");
+#if defined(_WIN32)
 
-	char* outputBuffer = (char*)malloc(16*4096);
+bool mapFile(const char* filepath, struct MappedFile* file) {
+	FILE *stream = fopen(filepath, "rb");
 
-	if (file == NULL) {
-		printf("Error in opening file: %s", filepath);
-		return NULL;
+	file->data = NULL;
+	file->size = 0;
+	if (stream == NULL) {
+		printf("Error in opening file: %s\n", filepath);
+		return false;
 	}
 
-	char c;
-	int bufferIndex = 0;
-	while ((c = fgetc(file)) != EOF) {
-		//printf("%c", c);
-		outputBuffer[bufferIndex] = c;
-		bufferIndex++;
+	fseek(stream, 0, SEEK_END);
+	long size = ftell(stream);
+	fseek(stream, 0, SEEK_SET);
+
+	char* buffer = size > 0 ? (char*)malloc(size) : NULL;
+	if (buffer != NULL)
+		file->size = fread(buffer, 1, size, stream);
+	file->data = buffer;
+	fclose(stream);
+	return size <= 0 || buffer != NULL;
+}
+
+void unmapFile(struct MappedFile* file) {
+	free((void*)file->data);
+	file->data = NULL;
+	file->size = 0;
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool mapFile(const char* filepath, struct MappedFile* file) {
+	int descriptor = open(filepath, O_RDONLY);
+
+	file->data = NULL;
+	file->size = 0;
+	if (descriptor < 0) {
+		printf("Error in opening file: %s\n", filepath);
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		printf("Error in reading file: %s\n", filepath);
+		close(descriptor);
+		return false;
+	}
+
+	// An empty file cannot be mapped, it is returned as an empty view
+	if (status.st_size > 0) {
+		void* mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (mapping == MAP_FAILED) {
+			printf("Error in mapping file: %s\n", filepath);
+			close(descriptor);
+			return false;
+		}
+		file->data = (const char*)mapping;
+		file->size = (size_t)status.st_size;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	close(descriptor);
+	return true;
+}
+
+void unmapFile(struct MappedFile* file) {
+	if (file->data != NULL)
+		munmap((void*)file->data, file->size);
+	file->data = NULL;
+	file->size = 0;
+}
+
+#endif
+
+char* readFile(char* filepath) {
+	struct MappedFile file;
+
+	if (!mapFile(filepath, &file))
+		return NULL;
+
+	char* outputBuffer = (char*)malloc(file.size + 1);
+	if (outputBuffer != NULL) {
+		if (file.size > 0)
+			memcpy(outputBuffer, file.data, file.size);
+		outputBuffer[file.size] = '\0';
 	}
 
-	outputBuffer[bufferIndex] = '\0';
-	fclose(file);
+	unmapFile(&file);
 	return outputBuffer;
 }
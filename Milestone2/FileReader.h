@@ -1,2 +1,12 @@
 #pragma once
-char* readFile(char* filepath);
\ No newline at end of file
+#include <stdbool.h>
+#include <stddef.h>
+
+struct MappedFile {
+    const char* data; // Read-only view of the whole file, not null-terminated
+    size_t size;
+};
+
+bool mapFile(const char* filepath, struct MappedFile* file);
+void unmapFile(struct MappedFile* file);
+char* readFile(char* filepath); // Null-terminated heap copy of the file, caller frees
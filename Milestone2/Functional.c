@@ -0,0 +1,327 @@
+#include "Functional.h"
+#include "Simulator.h"
+#include "Cpu.h"
+#include "Predecode.h"
+#include "Memory.h"
+#include <limits.h>
+#include <string.h>
+
+/* runSwitch and runThreaded work on a local copy of the register file: it cannot alias the memory pages or the
+   predecoded entries, so the compiler keeps their fields in host registers across guest register writes */
+static long long runSwitch(struct Cpu* cpu, long long instructionLimit) {
+    int registers[REGISTER_COUNT];
+    struct Memory* memory = &cpu->memory;
+    struct PredecodeTable* predecode = &cpu->predecode;
+    int lineCount = cpu->lineCount;
+    int programCounter = cpu->programCounter;
+    long long instructionsRetired = 0;
+
+    memcpy(registers, cpu->registers, sizeof(registers));
+
+    while (programCounter >= 0 && programCounter < lineCount && instructionsRetired < instructionLimit) {
+        const struct DecodedInstructionFields* fields = &predecodedEntryAt(predecode, programCounter)->fields;
+        int r1 = fields->r1;
+        int r2 = fields->r2;
+        int r3 = fields->r3;
+        int immediate = fields->immediate;
+
+        int nextProgramCounter = programCounter + 1;
+        int memoryAddress;
+
+        switch (fields->opcode) {
+            case 0: //ADD
+                registers[r1] = registers[r2] + registers[r3];
+                break;
+            case 1: //SUB
+                registers[r1] = registers[r2] - registers[r3];
+                break;
+            case 2: //MULI
+                registers[r1] = registers[r2] * immediate;
+                break;
+            case 3: //ADDI
+                registers[r1] = registers[r2] + immediate;
+                break;
+            case 4: //BNE
+                if (registers[r1] != registers[r2])
+                    nextProgramCounter = programCounter + 1 + immediate;
+                break;
+            case 5: //ANDI
+                registers[r1] = registers[r2] & immediate;
+                break;
+            case 6: //ORI
+                registers[r1] = registers[r2] | immediate;
+                break;
+            case 7: //J
+                nextProgramCounter = (programCounter & 0xF0000000) | fields->address;
+                break;
+            case 8: //SLL
+                registers[r1] = registers[r2] << fields->shamt;
+                break;
+            case 9: //SRL
+                registers[r1] = registers[r2] >> fields->shamt;
+                break;
+            case 10: //LW
+                memoryAddress = registers[r2] + immediate;
+                if (validMemoryAddress(memory, memoryAddress))
+                    registers[r1] = readMemory(memory, memoryAddress);
+                else
+                    reportMemoryAccessError(programCounter, memoryAddress);
+                break;
+            case 11: //SW
+                memoryAddress = registers[r2] + immediate;
+                if (validMemoryAddress(memory, memoryAddress)) {
+                    writeMemory(memory, memoryAddress, registers[r1]);
+                    invalidatePredecoded(predecode, memoryAddress);
+                } else {
+                    reportMemoryAccessError(programCounter, memoryAddress);
+                }
+                break;
+            default:
+                break;
+        }
+
+        registers[0] = 0;
+        programCounter = nextProgramCounter;
+        instructionsRetired++;
+    }
+
+    memcpy(cpu->registers, registers, sizeof(registers));
+    cpu->programCounter = programCounter;
+    return instructionsRetired;
+}
+
+/* Per-opcode handlers, attached to predecoded instructions on first execution */
+
+static int executeAdd(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] + cpu->registers[f->r3];
+    return pc + 1;
+}
+
+static int executeSub(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] - cpu->registers[f->r3];
+    return pc + 1;
+}
+
+static int executeMuli(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] * f->immediate;
+    return pc + 1;
+}
+
+static int executeAddi(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] + f->immediate;
+    return pc + 1;
+}
+
+static int executeBne(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    return cpu->registers[f->r1] != cpu->registers[f->r2] ? pc + 1 + f->immediate : pc + 1;
+}
+
+static int executeAndi(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] & f->immediate;
+    return pc + 1;
+}
+
+static int executeOri(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] | f->immediate;
+    return pc + 1;
+}
+
+static int executeJ(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    (void)cpu;
+    return (pc & 0xF0000000) | f->address;
+}
+
+static int executeSll(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] << f->shamt;
+    return pc + 1;
+}
+
+static int executeSrl(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    cpu->registers[f->r1] = cpu->registers[f->r2] >> f->shamt;
+    return pc + 1;
+}
+
+static int executeLw(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    int memoryAddress = cpu->registers[f->r2] + f->immediate;
+    if (validMemoryAddress(&cpu->memory, memoryAddress))
+        cpu->registers[f->r1] = readMemory(&cpu->memory, memoryAddress);
+    else
+        reportMemoryAccessError(pc, memoryAddress);
+    return pc + 1;
+}
+
+static int executeSw(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    int memoryAddress = cpu->registers[f->r2] + f->immediate;
+    if (validMemoryAddress(&cpu->memory, memoryAddress)) {
+        writeMemory(&cpu->memory, memoryAddress, cpu->registers[f->r1]);
+        invalidatePredecoded(&cpu->predecode, memoryAddress);
+    } else {
+        reportMemoryAccessError(pc, memoryAddress);
+    }
+    return pc + 1;
+}
+
+static int executeUnknown(struct Cpu* cpu, const struct DecodedInstructionFields* f, int pc) {
+    (void)cpu;
+    (void)f;
+    return pc + 1;
+}
+
+static const InstructionHandler instructionHandlers[16] = {
+    executeAdd, executeSub, executeMuli, executeAddi, executeBne, executeAndi, executeOri, executeJ,
+    executeSll, executeSrl, executeLw, executeSw, executeUnknown, executeUnknown, executeUnknown, executeUnknown
+};
+
+static long long runHandlers(struct Cpu* cpu, long long instructionLimit) {
+    struct PredecodeTable* predecode = &cpu->predecode;
+    int lineCount = cpu->lineCount;
+    long long instructionsRetired = 0;
+    int pc = cpu->programCounter;
+
+    while (pc >= 0 && pc < lineCount && instructionsRetired < instructionLimit) {
+        struct PredecodedInstruction* entry = predecodedEntryAt(predecode, pc);
+        if (entry->handler == NULL)
+            entry->handler = instructionHandlers[entry->fields.opcode];
+
+        pc = entry->handler(cpu, &entry->fields, pc);
+        cpu->registers[0] = 0;
+        instructionsRetired++;
+    }
+
+    cpu->programCounter = pc;
+    return instructionsRetired;
+}
+
+#if defined(__GNUC__)
+static long long runThreaded(struct Cpu* cpu, long long instructionLimit) {
+    static const void* opcodeLabels[16] = {
+        &&opAdd, &&opSub, &&opMuli, &&opAddi, &&opBne, &&opAndi, &&opOri, &&opJ,
+        &&opSll, &&opSrl, &&opLw, &&opSw, &&opUnknown, &&opUnknown, &&opUnknown, &&opUnknown
+    };
+    int registers[REGISTER_COUNT];
+    struct Memory* memory = &cpu->memory;
+    struct PredecodeTable* predecode = &cpu->predecode;
+    int lineCount = cpu->lineCount;
+    long long instructionsRetired = 0;
+    int pc = cpu->programCounter;
+
+    memcpy(registers, cpu->registers, sizeof(registers));
+    int memoryAddress;
+    struct PredecodedInstruction* entry;
+    const struct DecodedInstructionFields* f;
+
+    // Every handler ends in its own copy of this indirect jump, so the host predictor sees one branch per opcode
+#define DISPATCH_NEXT()                                                         \
+    do {                                                                        \
+        registers[0] = 0;                                                       \
+        if (pc < 0 || pc >= lineCount) goto done;                               \
+        if (instructionsRetired == instructionLimit) goto done;                 \
+        entry = predecodedEntryAt(predecode, pc);                               \
+        if (entry->threadedLabel == NULL)                                       \
+            entry->threadedLabel = opcodeLabels[entry->fields.opcode];          \
+        f = &entry->fields;                                                     \
+        instructionsRetired++;                                                  \
+        goto *entry->threadedLabel;                                             \
+    } while (0)
+
+    DISPATCH_NEXT();
+
+opAdd:
+    registers[f->r1] = registers[f->r2] + registers[f->r3];
+    pc++;
+    DISPATCH_NEXT();
+opSub:
+    registers[f->r1] = registers[f->r2] - registers[f->r3];
+    pc++;
+    DISPATCH_NEXT();
+opMuli:
+    registers[f->r1] = registers[f->r2] * f->immediate;
+    pc++;
+    DISPATCH_NEXT();
+opAddi:
+    registers[f->r1] = registers[f->r2] + f->immediate;
+    pc++;
+    DISPATCH_NEXT();
+opBne:
+    pc = registers[f->r1] != registers[f->r2] ? pc + 1 + f->immediate : pc + 1;
+    DISPATCH_NEXT();
+opAndi:
+    registers[f->r1] = registers[f->r2] & f->immediate;
+    pc++;
+    DISPATCH_NEXT();
+opOri:
+    registers[f->r1] = registers[f->r2] | f->immediate;
+    pc++;
+    DISPATCH_NEXT();
+opJ:
+    pc = (pc & 0xF0000000) | f->address;
+    DISPATCH_NEXT();
+opSll:
+    registers[f->r1] = registers[f->r2] << f->shamt;
+    pc++;
+    DISPATCH_NEXT();
+opSrl:
+    registers[f->r1] = registers[f->r2] >> f->shamt;
+    pc++;
+    DISPATCH_NEXT();
+opLw:
+    memoryAddress = registers[f->r2] + f->immediate;
+    if (validMemoryAddress(memory, memoryAddress))
+        registers[f->r1] = readMemory(memory, memoryAddress);
+    else
+        reportMemoryAccessError(pc, memoryAddress);
+    pc++;
+    DISPATCH_NEXT();
+opSw:
+    memoryAddress = registers[f->r2] + f->immediate;
+    if (validMemoryAddress(memory, memoryAddress)) {
+        writeMemory(memory, memoryAddress, registers[f->r1]);
+        invalidatePredecoded(predecode, memoryAddress);
+    } else {
+        reportMemoryAccessError(pc, memoryAddress);
+    }
+    pc++;
+    DISPATCH_NEXT();
+opUnknown:
+    pc++;
+    DISPATCH_NEXT();
+
+#undef DISPATCH_NEXT
+done:
+    memcpy(cpu->registers, registers, sizeof(registers));
+    cpu->programCounter = pc;
+    return instructionsRetired;
+}
+#endif
+
+long long runFunctional(struct Cpu* cpu, enum DispatchStyle dispatch) {
+    return runFunctionalFor(cpu, dispatch, 0);
+}
+
+long long runFunctionalFor(struct Cpu* cpu, enum DispatchStyle dispatch, long long instructionLimit) {
+    long long instructionsRetired;
+    if (instructionLimit <= 0) instructionLimit = LLONG_MAX;
+    switch (dispatch) {
+        case DISPATCH_SWITCH:
+            instructionsRetired = runSwitch(cpu, instructionLimit);
+            break;
+#if defined(__GNUC__)
+        case DISPATCH_THREADED:
+            instructionsRetired = runThreaded(cpu, instructionLimit);
+            break;
+#endif
+        default:
+            instructionsRetired = runHandlers(cpu, instructionLimit);
+            break;
+    }
+    cpu->counters.instructionsRetired = instructionsRetired; // No timing, so the other counters stay zero
+    return instructionsRetired;
+}
+
+const char* dispatchStyleName(enum DispatchStyle dispatch) {
+    switch (dispatch) {
+        case DISPATCH_SWITCH:   return "switch";
+        case DISPATCH_HANDLERS: return "handlers";
+        default:                return "threaded";
+    }
+}
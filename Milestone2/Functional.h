@@ -0,0 +1,16 @@
+#pragma once
+#include "Cpu.h"
+
+enum DispatchStyle {
+    DISPATCH_SWITCH,   // Portable: one switch on the opcode per instruction
+    DISPATCH_HANDLERS, // Per-opcode handler pointer attached to each predecoded instruction
+    DISPATCH_THREADED  // GCC computed-goto threading, falls back to handlers on other compilers
+};
+
+/* Runs the program loaded into cpu at ISA level straight from its memory, without the pipeline model or tracing.
+   Returns the number of instructions retired. */
+long long runFunctional(struct Cpu* cpu, enum DispatchStyle dispatch);
+/* Same, stopping early once instructionLimit instructions have retired, 0 for no limit. The run can be
+   picked up again from cpu->programCounter. */
+long long runFunctionalFor(struct Cpu* cpu, enum DispatchStyle dispatch, long long instructionLimit);
+const char* dispatchStyleName(enum DispatchStyle dispatch);
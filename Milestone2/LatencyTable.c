@@ -0,0 +1,74 @@
+#include "LatencyTable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* unitNames[UNIT_COUNT] = { "alu", "mul", "lsu" };
+
+void initUnitTimings(struct UnitTiming timings[UNIT_COUNT], bool outOfOrder) {
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        timings[unit].latency = 1;
+        timings[unit].pipelined = true;
+    }
+    if (outOfOrder) timings[UNIT_MULTIPLIER].latency = OUT_OF_ORDER_MULTIPLIER_LATENCY;
+}
+
+const char* functionalUnitName(enum FunctionalUnit unit) {
+    return unitNames[unit];
+}
+
+enum FunctionalUnit functionalUnitFor(int opcode) {
+    if (opcode == 2) return UNIT_MULTIPLIER;                  //MULI
+    if (opcode == 10 || opcode == 11) return UNIT_LOAD_STORE; //LW, SW
+    return UNIT_ALU;
+}
+
+static int parseUnit(const char* name) {
+    for (int unit = 0; unit < UNIT_COUNT; unit++)
+        if (strcmp(name, unitNames[unit]) == 0) return unit;
+    return -1;
+}
+
+bool loadUnitTimings(struct UnitTiming timings[UNIT_COUNT], const char* path) {
+    FILE* file = fopen(path, "r");
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+
+    if (file == NULL) {
+        printf("Error in opening file: %s\n", path);
+        return false;
+    }
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        char* fields[4];
+        int fieldCount = 0;
+        char* end;
+
+        lineNumber++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        for (char* field = strtok(line, " \t"); field != NULL && fieldCount < 4; field = strtok(NULL, " \t"))
+            fields[fieldCount++] = field;
+        if (fieldCount == 0) continue;
+
+        int unit = fieldCount == 3 ? parseUnit(fields[0]) : -1;
+        long latency = fieldCount == 3 ? strtol(fields[1], &end, 10) : 0;
+        if (fieldCount != 3) {
+            printf("%s: line %d: error: expected unit, latency and pipelined or unpipelined\n", path, lineNumber);
+            ok = false;
+        } else if (unit < 0) {
+            printf("%s: line %d: error: unknown unit '%s', expected alu, mul or lsu\n", path, lineNumber, fields[0]);
+            ok = false;
+        } else if (*end != '\0' || latency < 1 || latency > MAX_UNIT_LATENCY) {
+            printf("%s: line %d: error: latency must be 1 to %d: %s\n", path, lineNumber, MAX_UNIT_LATENCY, fields[1]);
+            ok = false;
+        } else if (strcmp(fields[2], "pipelined") != 0 && strcmp(fields[2], "unpipelined") != 0) {
+            printf("%s: line %d: error: expected pipelined or unpipelined: %s\n", path, lineNumber, fields[2]);
+            ok = false;
+        } else {
+            timings[unit].latency = (int)latency;
+            timings[unit].pipelined = strcmp(fields[2], "pipelined") == 0;
+        }
+    }
+    fclose(file);
+    return ok;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "Simulator.h"
+#include <stdbool.h>
+
+#define MAX_UNIT_LATENCY 100
+
+#define OUT_OF_ORDER_MULTIPLIER_LATENCY 3
+
+/* Every unit a single pipelined cycle, the timing of the original 5-stage pipeline. For the out-of-order
+   core the multiplier takes OUT_OF_ORDER_MULTIPLIER_LATENCY, its default before the table. */
+void initUnitTimings(struct UnitTiming timings[UNIT_COUNT], bool outOfOrder);
+
+/* Reads a latency table, one "unit latency pipelined|unpipelined" line per opcode class with unit one
+   of alu, mul and lsu, '#' starting a comment. Units the file leaves out keep their timing. Returns
+   false, having printed why, if the file cannot be read or a line does not parse. */
+bool loadUnitTimings(struct UnitTiming timings[UNIT_COUNT], const char* path);
+
+const char* functionalUnitName(enum FunctionalUnit unit);
+enum FunctionalUnit functionalUnitFor(int opcode);
@@ -0,0 +1,122 @@
+#include "Memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* allocateOrExit(size_t count, size_t size) {
+    void* block = calloc(count, size);
+    if (block == NULL) {
+        printf("Cannot allocate %zu bytes of main memory\n", count * size);
+        exit(1);
+    }
+    return block;
+}
+
+static void freePages(struct Memory* memory) {
+    for (int i = 0; i < memory->pageCount; i++)
+        free(lookupPage(memory, memory->pageNumbers[i] << PAGE_SHIFT));
+    for (int i = 0; i < memory->directorySize; i++)
+        free(memory->directory[i]);
+    free(memory->directory);
+    memory->directory = NULL;
+    memory->directorySize = 0;
+    memory->lastPageNumber = UINT32_MAX; // Never a page number
+    memory->lastPage = NULL;
+    memory->pageCount = 0;
+    memory->pagesSorted = true;
+}
+
+void initMemory(struct Memory* memory, int instructionWords, long long dataWords) {
+    freePages(memory);
+    memory->dataOffset = instructionWords;
+    memory->size = instructionWords + dataWords;
+    memory->directorySize = (int)((memory->size + (1LL << (PAGE_SHIFT + TABLE_SHIFT)) - 1) >> (PAGE_SHIFT + TABLE_SHIFT));
+    memory->directory = allocateOrExit(memory->directorySize > 0 ? memory->directorySize : 1, sizeof(int**));
+}
+
+void freeMemory(struct Memory* memory) {
+    freePages(memory);
+    free(memory->pageNumbers);
+    memory->pageNumbers = NULL;
+    memory->pageCapacity = 0;
+}
+
+int* lookupPage(struct Memory* memory, uint32_t address) {
+    int** table = memory->directory[address >> (PAGE_SHIFT + TABLE_SHIFT)];
+    int* page = table != NULL ? table[(address >> PAGE_SHIFT) & (TABLE_PAGES - 1)] : NULL;
+    if (page != NULL) {
+        memory->lastPageNumber = address >> PAGE_SHIFT;
+        memory->lastPage = page;
+    }
+    return page;
+}
+
+int* allocatePage(struct Memory* memory, uint32_t address) {
+    int** table = memory->directory[address >> (PAGE_SHIFT + TABLE_SHIFT)];
+    if (table == NULL) {
+        table = allocateOrExit(TABLE_PAGES, sizeof(int*));
+        memory->directory[address >> (PAGE_SHIFT + TABLE_SHIFT)] = table;
+    }
+
+    int* page = allocateOrExit(PAGE_WORDS, sizeof(int));
+    table[(address >> PAGE_SHIFT) & (TABLE_PAGES - 1)] = page;
+    memory->lastPageNumber = address >> PAGE_SHIFT;
+    memory->lastPage = page;
+
+    if (memory->pageCount == memory->pageCapacity) {
+        memory->pageCapacity = memory->pageCapacity > 0 ? memory->pageCapacity * 2 : 64;
+        memory->pageNumbers = realloc(memory->pageNumbers, memory->pageCapacity * sizeof(uint32_t));
+    }
+    if (memory->pageCount > 0 && memory->pageNumbers[memory->pageCount - 1] > address >> PAGE_SHIFT)
+        memory->pagesSorted = false;
+    memory->pageNumbers[memory->pageCount++] = address >> PAGE_SHIFT;
+    return page;
+}
+
+bool validMemoryAddress(const struct Memory* memory, int address) {
+    return (uint32_t)address < memory->size;
+}
+
+static int comparePageNumbers(const void* a, const void* b) {
+    uint32_t left = *(const uint32_t*)a, right = *(const uint32_t*)b;
+    return (left > right) - (left < right);
+}
+
+const uint32_t* residentPages(struct Memory* memory, int* count) {
+    if (!memory->pagesSorted) {
+        qsort(memory->pageNumbers, memory->pageCount, sizeof(uint32_t), comparePageNumbers);
+        memory->pagesSorted = true;
+    }
+    *count = memory->pageCount;
+    return memory->pageNumbers;
+}
+
+void captureMemory(struct Memory* memory, struct MemoryImage* image) {
+    int pageCount = memory->pageCount;
+
+    image->pageCount = pageCount;
+    image->pageNumbers = malloc((pageCount > 0 ? pageCount : 1) * sizeof(uint32_t));
+    image->words = malloc((pageCount > 0 ? pageCount : 1) * (size_t)PAGE_WORDS * sizeof(int));
+
+    for (int i = 0; i < pageCount; i++) {
+        image->pageNumbers[i] = memory->pageNumbers[i];
+        memcpy(image->words + (size_t)i * PAGE_WORDS, lookupPage(memory, memory->pageNumbers[i] << PAGE_SHIFT),
+               PAGE_WORDS * sizeof(int));
+    }
+}
+
+void restoreMemory(struct Memory* memory, const struct MemoryImage* image) {
+    initMemory(memory, memory->dataOffset, memory->size - memory->dataOffset);
+    for (int i = 0; i < image->pageCount; i++) {
+        int* page = allocatePage(memory, image->pageNumbers[i] << PAGE_SHIFT);
+        memcpy(page, image->words + (size_t)i * PAGE_WORDS, PAGE_WORDS * sizeof(int));
+    }
+}
+
+void freeMemoryImage(struct MemoryImage* image) {
+    free(image->pageNumbers);
+    free(image->words);
+    image->pageNumbers = NULL;
+    image->words = NULL;
+    image->pageCount = 0;
+}
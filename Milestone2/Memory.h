@@ -0,0 +1,67 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Sparse, word-addressed main memory (up to the full 32-bit space). Pages are allocated on the
+   first non-zero write; untouched memory reads as zero. */
+
+#define PAGE_SHIFT 10                      // 1024 words = 4 KiB per page
+#define PAGE_WORDS (1u << PAGE_SHIFT)
+#define TABLE_SHIFT 10                     // 1024 pages per second-level table
+#define TABLE_PAGES (1u << TABLE_SHIFT)
+#define MAX_MEMORY_WORDS (1LL << 32)
+
+struct Memory {
+    long long size;   // Words of address space
+    int dataOffset;   // Instruction region is [0, dataOffset), data region [dataOffset, size)
+    int*** directory; // [address >> 20][(address >> 10) & 1023], NULL where nothing is resident
+    int directorySize;
+    uint32_t lastPageNumber; // Most recently translated resident page, skips the walk for repeated accesses
+    int* lastPage;
+    uint32_t* pageNumbers;   // Every resident page, in allocation order until sorted
+    int pageCount;
+    int pageCapacity;
+    bool pagesSorted;
+};
+
+struct MemoryImage {
+    int pageCount;
+    uint32_t* pageNumbers;
+    int* words; // pageCount x PAGE_WORDS
+};
+
+/* memory must be zeroed before its first initMemory. Later calls drop every resident page, so their
+   cost is proportional to the pages touched rather than to the size of the address space. */
+void initMemory(struct Memory* memory, int instructionWords, long long dataWords);
+void freeMemory(struct Memory* memory);
+
+int* allocatePage(struct Memory* memory, uint32_t address);
+int* lookupPage(struct Memory* memory, uint32_t address); // Directory walk, NULL when the page is not resident
+bool validMemoryAddress(const struct Memory* memory, int address); // Whether address is in [0, size); prints nothing
+
+/* Resident page numbers in ascending order; valid until the next page is allocated */
+const uint32_t* residentPages(struct Memory* memory, int* count);
+
+void captureMemory(struct Memory* memory, struct MemoryImage* image);
+void restoreMemory(struct Memory* memory, const struct MemoryImage* image); // Replaces the whole contents
+void freeMemoryImage(struct MemoryImage* image);
+
+/* Fast paths; address must be below memory->size */
+static inline int* residentPage(struct Memory* memory, uint32_t address) {
+    return address >> PAGE_SHIFT == memory->lastPageNumber ? memory->lastPage : lookupPage(memory, address);
+}
+
+static inline int readMemory(struct Memory* memory, uint32_t address) {
+    int* page = residentPage(memory, address);
+    return page != NULL ? page[address & (PAGE_WORDS - 1)] : 0;
+}
+
+static inline void writeMemory(struct Memory* memory, uint32_t address, int value) {
+    int* page = residentPage(memory, address);
+    if (page == NULL) {
+        if (value == 0) return; // Already reads as zero
+        page = allocatePage(memory, address);
+    }
+    page[address & (PAGE_WORDS - 1)] = value;
+}
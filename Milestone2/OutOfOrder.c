@@ -0,0 +1,546 @@
+#include "OutOfOrder.h"
+#include "LatencyTable.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void commit(struct Cpu* cpu);
+static void writeback(struct Cpu* cpu);
+static void issue(struct Cpu* cpu);
+static void dispatch(struct Cpu* cpu);
+static void fetch(struct Cpu* cpu);
+
+static void printOutOfOrderCore(struct Cpu* cpu);
+
+void initOutOfOrderConfig(struct OutOfOrderConfig* config) {
+    config->reorderBufferSize = 64;
+    config->stations[UNIT_ALU] = 16;
+    config->stations[UNIT_MULTIPLIER] = 8;
+    config->stations[UNIT_LOAD_STORE] = 16;
+    config->units[UNIT_ALU] = 2;
+    config->units[UNIT_MULTIPLIER] = 1;
+    config->units[UNIT_LOAD_STORE] = 1; // One data port
+}
+
+void resetOutOfOrderCore(struct OutOfOrderCore* core) {
+    memset(core, 0, sizeof(*core));
+    for (int reg = 0; reg < REGISTER_COUNT; reg++)
+        core->renameTable[reg] = -1;
+}
+
+static int* settingField(struct OutOfOrderConfig* config, const char* key, int* maximum) {
+    char name[32];
+
+    if (strcmp(key, "rob") == 0) {
+        *maximum = MAX_REORDER_BUFFER;
+        return &config->reorderBufferSize;
+    }
+    if (strcmp(key, "lsq") == 0) {
+        *maximum = MAX_LOAD_STORE_QUEUE;
+        return &config->stations[UNIT_LOAD_STORE];
+    }
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        snprintf(name, sizeof(name), "%s-stations", functionalUnitName(unit));
+        if (unit != UNIT_LOAD_STORE && strcmp(key, name) == 0) {
+            *maximum = MAX_RESERVATION_STATIONS;
+            return &config->stations[unit];
+        }
+        snprintf(name, sizeof(name), "%s-units", functionalUnitName(unit));
+        if (strcmp(key, name) == 0) {
+            *maximum = MAX_FUNCTIONAL_UNITS;
+            return &config->units[unit];
+        }
+    }
+    return NULL;
+}
+
+bool parseOutOfOrderConfig(struct OutOfOrderConfig* config, const char* settings) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    for (char* setting = strtok(buffer, ","); setting != NULL; setting = strtok(NULL, ",")) {
+        char* separator = strchr(setting, '=');
+        char* end;
+        int maximum;
+
+        if (separator == NULL) {
+            printf("Out-of-order settings are key=value pairs: %s\n", setting);
+            return false;
+        }
+        *separator = '\0';
+        int* field = settingField(config, setting, &maximum);
+        if (field == NULL) {
+            printf("Unknown out-of-order setting: %s\n", setting);
+            return false;
+        }
+        long value = strtol(separator + 1, &end, 10);
+        if (*end != '\0' || value < 1 || value > maximum) {
+            printf("Out-of-order setting %s must be 1 to %d: %s\n", setting, maximum, separator + 1);
+            return false;
+        }
+        *field = (int)value;
+    }
+    return true;
+}
+
+static int opcodeOf(int instruction) {
+    return (instruction >> 28) & 0xF;
+}
+
+/* Register the instruction writes at commit: R1 for the ALU instructions and LW, none for BNE, J and SW */
+static int destinationOf(const struct DecodedInstructionFields* fields) {
+    switch (fields->opcode) {
+        case 4: case 7: case 11: return 0;
+        default: return fields->opcode <= 10 ? fields->r1 : 0;
+    }
+}
+
+/* The queues are circular; these map a position counted from the oldest entry to an array index */
+static int robIndexAt(const struct Cpu* cpu, int offset) {
+    return (cpu->outOfOrder.robHead + offset) % cpu->outOfOrderConfig.reorderBufferSize;
+}
+
+static int lsqIndexAt(const struct Cpu* cpu, int offset) {
+    return (cpu->outOfOrder.lsqHead + offset) % cpu->outOfOrderConfig.stations[UNIT_LOAD_STORE];
+}
+
+static bool inProgram(const struct Cpu* cpu) {
+    return cpu->programCounter >= 0 && cpu->programCounter < cpu->lineCount;
+}
+
+bool outOfOrderDone(const struct Cpu* cpu) {
+    return cpu->outOfOrder.robCount == 0 && cpu->outOfOrder.fetchCount == 0 && !inProgram(cpu);
+}
+
+int runOutOfOrderToCompletion(struct Cpu* cpu) {
+    return runOutOfOrderUntil(cpu, 0, 0);
+}
+
+int runOutOfOrderUntil(struct Cpu* cpu, long long cycleLimit, long long instructionLimit) {
+    do {
+        runOutOfOrderCycle(cpu);
+        cpu->cycle++;
+    } while (!outOfOrderDone(cpu) && !runLimitReached(cpu, cycleLimit, instructionLimit));
+    return cpu->cycle - 1;
+}
+
+void runOutOfOrderCycle(struct Cpu* cpu) {
+    bool busy = !outOfOrderDone(cpu); // The last cycle, whose commits end the run, is traced too
+
+    cpu->counters.cycles++;
+    // Oldest first: a result broadcast this cycle wakes up instructions that issue this cycle, and an
+    // instruction dispatched this cycle issues from the next
+    commit(cpu);
+    writeback(cpu);
+    issue(cpu);
+    dispatch(cpu);
+    fetch(cpu);
+
+    if (TRACE_AT(TRACE_LEVEL_CYCLE) && busy) printOutOfOrderCore(cpu);
+}
+
+/* Squashes everything younger than the instruction with the given sequence number, rebuilds the
+   rename table from what is left in the reorder buffer and refetches from nextPC */
+static void squashAfter(struct Cpu* cpu, long long sequence, int nextPC) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    cpu->counters.squashedInstructions += core->fetchCount;
+    core->fetchCount = 0;
+    while (core->robCount > 0 && core->reorderBuffer[robIndexAt(cpu, core->robCount - 1)].sequence > sequence) {
+        core->robCount--;
+        cpu->counters.squashedInstructions++;
+    }
+    // The squashed entries keep their contents until dispatch reuses them, so their sequence numbers can still be read
+    while (core->lsqCount > 0 && core->reorderBuffer[core->loadStoreQueue[lsqIndexAt(cpu, core->lsqCount - 1)].robIndex].sequence > sequence)
+        core->lsqCount--;
+    for (int unit = 0; unit < UNIT_LOAD_STORE; unit++)
+        for (int s = 0; s < cpu->outOfOrderConfig.stations[unit]; s++)
+            if (core->stations[unit][s].busy && core->reorderBuffer[core->stations[unit][s].robIndex].sequence > sequence)
+                core->stations[unit][s].busy = false;
+
+    for (int reg = 0; reg < REGISTER_COUNT; reg++)
+        core->renameTable[reg] = -1;
+    for (int offset = 0; offset < core->robCount; offset++) {
+        int index = robIndexAt(cpu, offset);
+        if (core->reorderBuffer[index].destination != 0) core->renameTable[core->reorderBuffer[index].destination] = index;
+    }
+    cpu->programCounter = nextPC;
+    TRACE_INSTRUCTION("\033[1;35m--- MISPREDICTION, SQUASHING YOUNGER INSTRUCTIONS ---\033[0m\n");
+}
+
+/* Whether a store into the instruction region overwrote a word that is already in flight */
+static bool storeHitsFetched(const struct Cpu* cpu, int address) {
+    const struct OutOfOrderCore* core = &cpu->outOfOrder;
+    for (int offset = 0; offset < core->robCount; offset++)
+        if (core->reorderBuffer[robIndexAt(cpu, offset)].pc == address) return true;
+    for (int i = 0; i < core->fetchCount; i++)
+        if (core->fetchQueue[(core->fetchHead + i) % FETCH_QUEUE_SIZE].pc == address) return true;
+    return false;
+}
+
+static void commit(struct Cpu* cpu) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    for (int n = 0; n < cpu->issueWidth && core->robCount > 0; n++) {
+        int index = core->robHead;
+        struct ReorderBufferEntry* entry = &core->reorderBuffer[index];
+        int opcode = entry->fields.opcode;
+        bool isBranch = opcode == 4 || opcode == 7;
+
+        if (entry->state != ROB_DONE) return;
+        core->robHead = (core->robHead + 1) % cpu->outOfOrderConfig.reorderBufferSize;
+        core->robCount--;
+        cpu->counters.instructionsRetired++;
+        cpu->counters.retiredByOpcode[opcodeOf(entry->instruction)]++;
+
+        // Trained in program order, so wrong-path branches never reach the predictor
+        if (isBranch || entry->prediction.targetKnown)
+            updateBranchPredictor(&cpu->predictor, &entry->prediction, entry->pc, isBranch, opcode == 7, entry->taken, entry->result);
+        if (opcode == 4) {
+            cpu->counters.branches++;
+            cpu->counters.flushesBne += entry->mispredicted;
+        } else if (opcode == 7) {
+            cpu->counters.jumps++;
+            cpu->counters.flushesJump += entry->mispredicted;
+        }
+
+        // An out-of-bounds LW leaves its register as it was
+        bool valid = entry->unit != UNIT_LOAD_STORE ||
+            validMemoryAddress(&cpu->memory, core->loadStoreQueue[core->lsqHead].address);
+        if (entry->destination != 0) {
+            if (valid) {
+                cpu->registers[entry->destination] = entry->result;
+                TRACE_INSTRUCTION("\nCOMMIT: R%d set to %d\n", entry->destination, entry->result);
+            }
+            if (core->renameTable[entry->destination] == index) core->renameTable[entry->destination] = -1;
+        }
+        if (entry->unit != UNIT_LOAD_STORE) continue;
+
+        struct LoadStoreEntry* access = &core->loadStoreQueue[core->lsqHead];
+        core->lsqHead = (core->lsqHead + 1) % cpu->outOfOrderConfig.stations[UNIT_LOAD_STORE];
+        core->lsqCount--;
+        if (!valid) reportMemoryAccessError(entry->pc, access->address);
+        if (!access->isStore) {
+            cpu->counters.loads++;
+            // The younger instructions may have used the result it was issued with, so they run again
+            if (!valid) {
+                squashAfter(cpu, entry->sequence, entry->pc + 1);
+                return;
+            }
+            continue;
+        }
+        cpu->counters.stores++;
+        if (!valid) continue;
+        if (cpu->dataCache.config.enabled) // Off the critical path, the store only updates the cache state
+            accessCache(&cpu->dataCache, entry->pc, access->address, true, cpu->cycle);
+        writeMemory(&cpu->memory, access->address, access->data.value);
+        invalidatePredecoded(&cpu->predecode, access->address);
+        TRACE_INSTRUCTION("COMMIT: memory address '%d' written with value '0x%08X', decimal '%d'\n", access->address,
+                          access->data.value, access->data.value);
+        // Self-modifying code: what was fetched from the overwritten word is stale
+        if (storeHitsFetched(cpu, access->address)) {
+            squashAfter(cpu, entry->sequence, entry->pc + 1);
+            return;
+        }
+    }
+}
+
+/* Common data bus: hands a result to every reservation station and LSQ entry waiting for it */
+static void broadcast(struct Cpu* cpu, int robIndex, int value) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    for (int unit = 0; unit < UNIT_LOAD_STORE; unit++) {
+        for (int s = 0; s < cpu->outOfOrderConfig.stations[unit]; s++) {
+            struct ReservationStation* station = &core->stations[unit][s];
+            if (!station->busy) continue;
+            for (int i = 0; i < 2; i++) {
+                if (station->operands[i].tag != robIndex) continue;
+                station->operands[i].value = value;
+                station->operands[i].tag = -1;
+            }
+        }
+    }
+    for (int offset = 0; offset < core->lsqCount; offset++) {
+        struct LoadStoreEntry* access = &core->loadStoreQueue[lsqIndexAt(cpu, offset)];
+        if (access->base.tag == robIndex) {
+            access->base.value = value;
+            access->base.tag = -1;
+        }
+        if (access->data.tag == robIndex) {
+            access->data.value = value;
+            access->data.tag = -1;
+        }
+    }
+}
+
+/* Results reaching the common data bus this cycle. A mispredicted BNE squashes the instructions after
+   it here, without waiting to commit. */
+static void writeback(struct Cpu* cpu) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    for (int offset = 0; offset < core->robCount; offset++) {
+        int index = robIndexAt(cpu, offset);
+        struct ReorderBufferEntry* entry = &core->reorderBuffer[index];
+        if (entry->state != ROB_EXECUTING || entry->completeCycle > cpu->cycle) continue;
+
+        entry->state = ROB_DONE;
+        if (entry->destination != 0) broadcast(cpu, index, entry->result);
+        if (entry->fields.opcode != 4) continue;
+
+        int nextPC = entry->taken ? entry->result : entry->pc + 1;
+        int predictedPC = entry->prediction.taken ? entry->prediction.target : entry->pc + 1;
+        if (nextPC != predictedPC) {
+            entry->mispredicted = true;
+            squashAfter(cpu, entry->sequence, nextPC);
+        }
+    }
+}
+
+static void executeOperation(struct ReorderBufferEntry* entry, int a, int b) {
+    const struct DecodedInstructionFields* fields = &entry->fields;
+
+    switch (fields->opcode) {
+        case 0: entry->result = a + b; break;                  //ADD
+        case 1: entry->result = a - b; break;                  //SUB
+        case 2: entry->result = a * fields->immediate; break;  //MULI
+        case 3: entry->result = a + fields->immediate; break;  //ADDI
+        case 4:                                                //BNE
+            entry->result = entry->pc + 1 + fields->immediate;
+            entry->taken = a != b;
+            break;
+        case 5: entry->result = a & fields->immediate; break;  //ANDI
+        case 6: entry->result = a | fields->immediate; break;  //ORI
+        case 8: entry->result = a << fields->shamt; break;     //SLL
+        case 9: entry->result = a >> fields->shamt; break;     //SRL
+        default: break;
+    }
+}
+
+/* A unit of the type that can start an instruction this cycle, or -1 */
+static int freeUnit(const struct Cpu* cpu, int unit) {
+    for (int instance = 0; instance < cpu->outOfOrderConfig.units[unit]; instance++)
+        if (cpu->outOfOrder.unitFreeCycle[unit][instance] <= cpu->cycle) return instance;
+    return -1;
+}
+
+/* A pipelined unit takes the next instruction a cycle later, an unpipelined one once this result is out */
+static void startExecution(struct Cpu* cpu, struct ReorderBufferEntry* entry, int unit, int instance, int latency) {
+    entry->state = ROB_EXECUTING;
+    entry->completeCycle = cpu->cycle + latency;
+    cpu->outOfOrder.unitFreeCycle[unit][instance] = cpu->cycle + (cpu->unitTimings[unit].pipelined ? 1 : latency);
+}
+
+/* Oldest ready station of the unit, or NULL */
+static struct ReservationStation* selectReady(struct Cpu* cpu, int unit) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+    struct ReservationStation* oldest = NULL;
+
+    for (int s = 0; s < cpu->outOfOrderConfig.stations[unit]; s++) {
+        struct ReservationStation* station = &core->stations[unit][s];
+        if (!station->busy || station->operands[0].tag >= 0 || station->operands[1].tag >= 0) continue;
+        if (oldest == NULL || core->reorderBuffer[station->robIndex].sequence < core->reorderBuffer[oldest->robIndex].sequence)
+            oldest = station;
+    }
+    return oldest;
+}
+
+/* Loads go once every older store has its address (conservative disambiguation) and take the value of
+   the youngest older store to the same address, or read memory. A unit spends one cycle on the address,
+   then a load the load/store latency on the access. */
+static void issueLoadStore(struct Cpu* cpu) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+    bool olderStorePending = false;
+    int instance;
+
+    for (int offset = 0; offset < core->lsqCount && (instance = freeUnit(cpu, UNIT_LOAD_STORE)) >= 0; offset++) {
+        struct LoadStoreEntry* access = &core->loadStoreQueue[lsqIndexAt(cpu, offset)];
+        struct ReorderBufferEntry* entry = &core->reorderBuffer[access->robIndex];
+
+        if (access->issued) continue;
+        if (access->isStore) {
+            if (access->base.tag >= 0 || access->data.tag >= 0) {
+                olderStorePending = true;
+                continue;
+            }
+            access->address = access->base.value + entry->fields.immediate;
+            access->issued = true;
+            startExecution(cpu, entry, UNIT_LOAD_STORE, instance, 1);
+            continue;
+        }
+        if (olderStorePending || access->base.tag >= 0) continue;
+
+        access->address = access->base.value + entry->fields.immediate;
+        access->issued = true;
+        bool forwarded = false;
+        for (int older = offset - 1; older >= 0 && !forwarded; older--) {
+            const struct LoadStoreEntry* store = &core->loadStoreQueue[lsqIndexAt(cpu, older)];
+            if (!store->isStore || store->address != access->address) continue;
+            entry->result = store->data.value;
+            forwarded = true;
+            cpu->counters.storeForwards++;
+        }
+        int cacheCycles = 0;
+        if (!forwarded) {
+            bool valid = validMemoryAddress(&cpu->memory, access->address);
+            entry->result = valid ? readMemory(&cpu->memory, access->address) : 0; // Undone at commit
+            if (valid && cpu->dataCache.config.enabled)
+                cacheCycles = accessCache(&cpu->dataCache, entry->pc, access->address, false, cpu->cycle + 1) - 1; // After the address cycle
+            cpu->counters.stallCycles[STALL_DATA_CACHE] += cacheCycles;
+        }
+        startExecution(cpu, entry, UNIT_LOAD_STORE, instance, 1 + cpu->unitTimings[UNIT_LOAD_STORE].latency + cacheCycles);
+    }
+}
+
+static void issue(struct Cpu* cpu) {
+    for (int unit = 0; unit < UNIT_LOAD_STORE; unit++) {
+        int instance;
+        while ((instance = freeUnit(cpu, unit)) >= 0) {
+            struct ReservationStation* station = selectReady(cpu, unit);
+            if (station == NULL) break;
+
+            struct ReorderBufferEntry* entry = &cpu->outOfOrder.reorderBuffer[station->robIndex];
+            executeOperation(entry, station->operands[0].value, station->operands[1].value);
+            startExecution(cpu, entry, unit, instance, cpu->unitTimings[unit].latency);
+            station->busy = false;
+        }
+    }
+    issueLoadStore(cpu);
+}
+
+/* A source register through the rename table: the register file, a finished result still in the
+   reorder buffer, or a tag to wait on */
+static struct RenamedOperand renameOperand(struct Cpu* cpu, int reg) {
+    struct RenamedOperand operand = { cpu->registers[reg], -1 };
+    int producer = cpu->outOfOrder.renameTable[reg];
+
+    if (producer < 0) return operand;
+    if (cpu->outOfOrder.reorderBuffer[producer].state == ROB_DONE) {
+        operand.value = cpu->outOfOrder.reorderBuffer[producer].result;
+        cpu->counters.forwardedOperands++;
+    } else {
+        operand.tag = producer;
+    }
+    return operand;
+}
+
+static struct ReservationStation* freeStation(struct Cpu* cpu, int unit) {
+    for (int s = 0; s < cpu->outOfOrderConfig.stations[unit]; s++)
+        if (!cpu->outOfOrder.stations[unit][s].busy) return &cpu->outOfOrder.stations[unit][s];
+    return NULL;
+}
+
+/* Renames up to the issue width of instructions from the fetch queue, in order, into the reorder buffer
+   and a reservation station or the LSQ. J is done here; so is any other instruction IF took for a
+   taken branch, which refetches from the next word. */
+static void dispatch(struct Cpu* cpu) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+    const struct OutOfOrderConfig* config = &cpu->outOfOrderConfig;
+
+    for (int n = 0; n < cpu->issueWidth && core->fetchCount > 0; n++) {
+        const struct FetchedInstruction* fetched = &core->fetchQueue[core->fetchHead];
+        if (fetched->readyCycle > cpu->cycle) return;
+        const struct DecodedInstructionFields* fields = predecodedFor(&cpu->predecode, fetched->pc, fetched->instruction);
+        int unit = functionalUnitFor(fields->opcode);
+        struct ReservationStation* station = NULL;
+
+        if (core->robCount == config->reorderBufferSize) {
+            cpu->counters.dispatchStalls[DISPATCH_STALL_REORDER_BUFFER]++;
+            return;
+        }
+        if (unit == UNIT_LOAD_STORE && core->lsqCount == config->stations[UNIT_LOAD_STORE]) {
+            cpu->counters.dispatchStalls[DISPATCH_STALL_LOAD_STORE]++;
+            return;
+        }
+        if (unit != UNIT_LOAD_STORE && fields->opcode != 7 && (station = freeStation(cpu, unit)) == NULL) {
+            cpu->counters.dispatchStalls[DISPATCH_STALL_STATIONS]++;
+            return;
+        }
+
+        int index = robIndexAt(cpu, core->robCount++);
+        struct ReorderBufferEntry* entry = &core->reorderBuffer[index];
+        memset(entry, 0, sizeof(*entry));
+        entry->sequence = core->nextSequence++;
+        entry->instruction = fetched->instruction;
+        entry->pc = fetched->pc;
+        entry->fields = *fields;
+        entry->prediction = fetched->prediction;
+        entry->unit = unit;
+        entry->destination = destinationOf(fields);
+        entry->state = ROB_WAITING;
+        core->fetchHead = (core->fetchHead + 1) % FETCH_QUEUE_SIZE;
+        core->fetchCount--;
+
+        if (fields->opcode == 7) { //J
+            entry->result = (entry->pc & 0xF0000000) | fields->address;
+            entry->taken = true;
+            entry->state = ROB_DONE;
+        } else if (unit == UNIT_LOAD_STORE) {
+            struct LoadStoreEntry* access = &core->loadStoreQueue[lsqIndexAt(cpu, core->lsqCount++)];
+            access->robIndex = index;
+            access->isStore = fields->opcode == 11;
+            access->base = renameOperand(cpu, fields->r2);
+            access->data = access->isStore ? renameOperand(cpu, fields->r1) : (struct RenamedOperand){ 0, -1 };
+            access->issued = false;
+        } else {
+            struct RenamedOperand none = { 0, -1 };
+            station->busy = true;
+            station->robIndex = index;
+            station->operands[0] = renameOperand(cpu, fields->r2);
+            station->operands[1] = fields->opcode <= 1 ? renameOperand(cpu, fields->r3)   //ADD, SUB
+                                 : fields->opcode == 4 ? renameOperand(cpu, fields->r1)   //BNE
+                                 : none;
+        }
+        if (entry->destination != 0) core->renameTable[entry->destination] = index;
+
+        // Decode knows where a J goes and that anything else but a BNE falls through
+        int predictedPC = entry->prediction.taken ? entry->prediction.target : entry->pc + 1;
+        int nextPC = fields->opcode == 7 ? entry->result : entry->pc + 1;
+        if (fields->opcode != 4 && predictedPC != nextPC) {
+            entry->mispredicted = true;
+            squashAfter(cpu, entry->sequence, nextPC);
+        }
+    }
+}
+
+/* Fills the fetch queue with up to the issue width of words, ending the group after a predicted-taken
+   branch. The I-cache blocks: after a miss nothing more is fetched until the line is in. */
+static void fetch(struct Cpu* cpu) {
+    struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    if (core->fetchResumeCycle > cpu->cycle) {
+        cpu->counters.stallCycles[STALL_INSTRUCTION_CACHE]++;
+        return;
+    }
+    for (int n = 0; n < cpu->issueWidth && core->fetchCount < FETCH_QUEUE_SIZE && inProgram(cpu); n++) {
+        struct FetchedInstruction* fetched = &core->fetchQueue[(core->fetchHead + core->fetchCount) % FETCH_QUEUE_SIZE];
+        fetched->instruction = readMemory(&cpu->memory, cpu->programCounter);
+        fetched->pc = cpu->programCounter;
+        fetched->readyCycle = cpu->cycle + 1;
+        if (cpu->instructionCache.config.enabled) {
+            fetched->readyCycle = cpu->cycle + accessCache(&cpu->instructionCache, cpu->programCounter, cpu->programCounter, false, cpu->cycle);
+            if (fetched->readyCycle > core->fetchResumeCycle) core->fetchResumeCycle = fetched->readyCycle;
+        }
+        fetched->prediction = predictBranch(&cpu->predictor, cpu->programCounter);
+        cpu->programCounter = fetched->prediction.taken ? fetched->prediction.target : cpu->programCounter + 1;
+        if (fetched->instruction == 0) return; // A zero word is a bubble, as in the pipeline
+        core->fetchCount++;
+        if (fetched->prediction.taken) return;
+    }
+}
+
+static void printOutOfOrderCore(struct Cpu* cpu) {
+    static const char* stateNames[] = { "waiting", "executing", "done" };
+    const struct OutOfOrderCore* core = &cpu->outOfOrder;
+
+    printf("\033[1;31m--- Cycle %d ---\033[0m\n", cpu->cycle);
+    printf("  PC: %d, fetch queue %d, ROB %d/%d, LSQ %d/%d\n", cpu->programCounter, core->fetchCount, core->robCount,
+           cpu->outOfOrderConfig.reorderBufferSize, core->lsqCount, cpu->outOfOrderConfig.stations[UNIT_LOAD_STORE]);
+    printf("\033[1;34m");
+    for (int offset = 0; offset < core->robCount; offset++) {
+        int index = robIndexAt(cpu, offset);
+        const struct ReorderBufferEntry* entry = &core->reorderBuffer[index];
+        printf("  ROB%-3d %-20s %s\n", index, getInstructionTextAt(cpu, entry->pc, entry->instruction), stateNames[entry->state]);
+    }
+    printf("\033[0m");
+}
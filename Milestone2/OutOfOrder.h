@@ -0,0 +1,19 @@
+#pragma once
+#include "Cpu.h"
+
+/* Cycle-level Tomasulo model, the alternative to the in-order pipeline: registers renamed through a
+   reorder buffer, reservation stations per functional unit, a load/store queue forwarding stores to
+   younger loads, and in-order commit. Fetches, dispatches and commits up to cpu->issueWidth
+   instructions per cycle, sized by cpu->outOfOrderConfig. */
+void runOutOfOrderCycle(struct Cpu* cpu);
+bool outOfOrderDone(const struct Cpu* cpu);
+int runOutOfOrderToCompletion(struct Cpu* cpu); // Steps until the core drains, returns the number of cycles taken
+int runOutOfOrderUntil(struct Cpu* cpu, long long cycleLimit, long long instructionLimit); // Or stops at a limit, see runLimitReached
+
+void initOutOfOrderConfig(struct OutOfOrderConfig* config);
+void resetOutOfOrderCore(struct OutOfOrderCore* core);
+
+/* Applies comma-separated key=value settings, e.g. "rob=128,mul-units=2". Keys: rob, lsq,
+   alu-stations, mul-stations, alu-units, mul-units and lsu-units; the units take their latencies from
+   cpu->unitTimings. Returns false, having printed why, on an unknown key or a value out of range. */
+bool parseOutOfOrderConfig(struct OutOfOrderConfig* config, const char* settings);
@@ -0,0 +1,837 @@
+#include "Pipeline.h"
+#include "LatencyTable.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+// With a shared memory port ID and the first EX stage each hold an instruction for two cycles, the
+// other stages always take one
+#define SHARED_PORT_DECODE_CYCLES 2
+#define SHARED_PORT_EXECUTE_CYCLES 2
+
+// Source registers an instruction reads, see operandMask
+#define READS_R1 1
+#define READS_R2 2
+#define READS_R3 4
+
+/* Positions in Pipeline.stages for a given depth: IF, ID, the EX stages, the MEM stages, WB. Stages
+   beyond five split EX and MEM between them, EX taking the odd one. */
+struct StageLayout {
+    int depth;
+    int firstExecute, lastExecute; // Operands are bypassed into the first, the ALU works in the last
+    int firstMemory, lastMemory;   // Memory is accessed in the last
+    int writeback;
+    int decodeCycles, executeCycles; // Occupancy of ID and the first EX stage
+};
+
+static void fetch(struct Cpu* cpu);
+static void decode(struct Cpu* cpu, const struct StageLayout* layout);
+static void execute(struct Cpu* cpu, const struct StageLayout* layout, int stage);
+static void memory(struct Cpu* cpu, const struct StageLayout* layout, int stage);
+static void writeback(struct Cpu* cpu, const struct StageLayout* layout);
+static void drainStoreBuffer(struct Cpu* cpu);
+
+static void printPipeline(struct Cpu* cpu);
+static void printRegistersMinimal(struct Cpu* cpu);
+
+static struct StageLayout stageLayout(const struct Cpu* cpu) {
+    struct StageLayout layout;
+    int executeStages = 1 + (cpu->pipelineDepth - MIN_PIPELINE_DEPTH + 1) / 2;
+
+    layout.depth = cpu->pipelineDepth;
+    layout.firstExecute = 2;
+    layout.lastExecute = layout.firstExecute + executeStages - 1;
+    layout.firstMemory = layout.lastExecute + 1;
+    layout.lastMemory = layout.depth - 2;
+    layout.writeback = layout.depth - 1;
+    layout.decodeCycles = cpu->memoryPorts == MEMORY_SHARED_PORT ? SHARED_PORT_DECODE_CYCLES : 1;
+    layout.executeCycles = cpu->memoryPorts == MEMORY_SHARED_PORT ? SHARED_PORT_EXECUTE_CYCLES : 1;
+    return layout;
+}
+
+const char* resolveStageName(enum ResolveStage stage) {
+    switch (stage) {
+        case RESOLVE_IN_DECODE:  return "id";
+        case RESOLVE_IN_MEMORY:  return "mem";
+        default:                 return "ex";
+    }
+}
+
+int parseResolveStage(const char* name) {
+    if (strcmp(name, "id") == 0) return RESOLVE_IN_DECODE;
+    if (strcmp(name, "ex") == 0) return RESOLVE_IN_EXECUTE;
+    if (strcmp(name, "mem") == 0) return RESOLVE_IN_MEMORY;
+    return -1;
+}
+
+const char* memoryPortsName(enum MemoryPorts ports) {
+    return ports == MEMORY_SPLIT_PORTS ? "split" : "shared";
+}
+
+int parseMemoryPorts(const char* name) {
+    if (strcmp(name, "shared") == 0) return MEMORY_SHARED_PORT;
+    if (strcmp(name, "split") == 0) return MEMORY_SPLIT_PORTS;
+    return -1;
+}
+
+/* The numbers are reduced modulo the limits they never reach, so the compiler can see every name fits */
+const char* pipelineStageName(const struct Cpu* cpu, int stage) {
+    static char name[BINARY_TRACE_STAGE_NAME];
+    struct StageLayout layout = stageLayout(cpu);
+
+    if (stage == 0) return "IF";
+    if (stage == 1) return "ID";
+    if (stage == layout.writeback) return "WB";
+    if (stage <= layout.lastExecute) {
+        if (layout.firstExecute == layout.lastExecute) return "EX";
+        snprintf(name, sizeof(name), "EX%u", (unsigned)(stage - layout.firstExecute + 1) % MAX_PIPELINE_DEPTH);
+    } else {
+        if (layout.firstMemory == layout.lastMemory) return "MEM";
+        snprintf(name, sizeof(name), "MEM%u", (unsigned)(stage - layout.firstMemory + 1) % MAX_PIPELINE_DEPTH);
+    }
+    return name;
+}
+
+/* One column per stage, or per issue slot of each stage ("EX.0", "EX.1", ...) when wider than one */
+void pipelineTraceLayout(const struct Cpu* cpu, struct BinaryTraceLayout* layout) {
+    memset(layout, 0, sizeof(*layout));
+    for (int stage = 0; stage < cpu->pipelineDepth; stage++) {
+        for (int slot = 0; slot < cpu->issueWidth; slot++) {
+            char* name = layout->stageNames[layout->stageCount++];
+            if (cpu->issueWidth == 1)
+                snprintf(name, BINARY_TRACE_STAGE_NAME, "%s", pipelineStageName(cpu, stage));
+            else
+                snprintf(name, BINARY_TRACE_STAGE_NAME, "%.5s.%u", pipelineStageName(cpu, stage), (unsigned)slot % MAX_ISSUE_WIDTH);
+        }
+    }
+}
+
+bool pipelineDone(const struct Cpu* cpu) {
+    for (int stage = 0; stage < cpu->pipelineDepth; stage++)
+        if (cpu->pipeline.stages[stage].size != 0) return false;
+    return cpu->pipeline.storeBuffer.count == 0;
+}
+
+/* Steps the pipeline until it drains, returns the number of cycles taken */
+int runPipelineToCompletion(struct Cpu* cpu) {
+    return runPipelineUntil(cpu, 0, 0);
+}
+
+int runPipelineUntil(struct Cpu* cpu, long long cycleLimit, long long instructionLimit) {
+    do {
+        runPipeline(cpu);
+        cpu->cycle++;
+    } while (!pipelineDone(cpu) && !runLimitReached(cpu, cycleLimit, instructionLimit));
+    return cpu->cycle - 1;
+}
+
+void runPipeline(struct Cpu* cpu) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct StageLayout layout = stageLayout(cpu);
+    // A cycle is traced when anything was in flight at its start or its end: the last one, in which WB or
+    // the store buffer drains, ends the run but still has its writes to show
+    bool busy = !pipelineDone(cpu);
+
+    cpu->counters.cycles++;
+    // Oldest first, so every stage sees the group ahead of it already moved on for this cycle
+    drainStoreBuffer(cpu);
+    writeback(cpu, &layout);
+    for (int stage = layout.lastMemory; stage >= layout.firstMemory; stage--)
+        memory(cpu, &layout, stage);
+    for (int stage = layout.lastExecute; stage >= layout.firstExecute; stage--)
+        execute(cpu, &layout, stage);
+    decode(cpu, &layout);
+    fetch(cpu);
+    busy |= !pipelineDone(cpu);
+
+    if (TRACE_AT(TRACE_LEVEL_CYCLE) && busy){
+    printf("\033[1;31m--- Cycle %d ---\033[0m\n", cpu->cycle);
+    printPipeline(cpu);
+    printRegistersMinimal(cpu);
+    }
+
+    if (binaryTraceEnabled && busy) {
+        int stageInstructions[BINARY_TRACE_MAX_STAGES];
+        int column = 0;
+        for (int stage = 0; stage < layout.depth; stage++) {
+            const struct PipelineGroup* group = &pipeline->stages[stage];
+            for (int slot = 0; slot < cpu->issueWidth; slot++)
+                stageInstructions[column++] = slot < group->size ? group->slots[slot].instruction : 0;
+        }
+        traceEndCycle(cpu->cycle, cpu->programCounter, stageInstructions);
+    }
+    //printMainMemoryMinimal();
+
+}
+
+static int opcodeOf(int instruction) {
+    return (instruction >> 28) & 0xF;
+}
+
+static bool isBranchOrJump(int opcode) {
+    return opcode == 4 || opcode == 7;
+}
+
+static int operandMask(int opcode) {
+    switch (opcode) {
+        case 0: case 1:  return READS_R2 | READS_R3; //ADD, SUB
+        case 4: case 11: return READS_R1 | READS_R2; //BNE, SW
+        case 7:          return 0;                   //J
+        default:         return READS_R2;
+    }
+}
+
+/* Register the instruction writes in WB: R1 for the ALU instructions and LW, none for BNE, J and SW */
+static int destinationOf(const struct DecodedInstructionFields* fields) {
+    switch (fields->opcode) {
+        case 4: case 7: case 11: return 0;
+        default: return fields->opcode <= 10 ? fields->r1 : 0;
+    }
+}
+
+/* Hands the first count instructions of a finished group to the next stage, which must have moved its
+   own on. The rest stay behind, still finished. */
+static bool pullGroup(struct PipelineGroup* from, struct PipelineGroup* to, int cycles, int count) {
+    if (from->size == 0 || from->cyclesRemaining != 0 || to->size != 0 || count == 0) return false;
+    for (int slot = 0; slot < count; slot++)
+        to->slots[slot] = from->slots[slot];
+    to->size = count;
+    to->cyclesRemaining = cycles;
+    to->unitBusy = false;
+    from->size -= count;
+    for (int slot = 0; slot < from->size; slot++)
+        from->slots[slot] = from->slots[slot + count];
+    return true;
+}
+
+/* Unit an instruction works in at the last EX stage, where LW and SW add up their address on the ALU,
+   or at the last MEM stage; -1 for none */
+static int stageUnitFor(int opcode, bool memoryStage) {
+    int unit = functionalUnitFor(opcode);
+    if (memoryStage) return unit == UNIT_LOAD_STORE ? unit : -1;
+    return unit == UNIT_LOAD_STORE ? UNIT_ALU : unit;
+}
+
+/* Cycles beyond the first that an unpipelined unit holds the group in its stage, for the slowest slot */
+static int unpipelinedCycles(const struct Cpu* cpu, const struct PipelineGroup* group, bool memoryStage) {
+    int cycles = 0;
+    for (int slot = 0; slot < group->size; slot++) {
+        int unit = stageUnitFor(group->slots[slot].fields.opcode, memoryStage);
+        if (unit < 0) continue;
+        const struct UnitTiming* timing = &cpu->unitTimings[unit];
+        if (!timing->pipelined && timing->latency - 1 > cycles) cycles = timing->latency - 1;
+    }
+    return cycles;
+}
+
+/* The youngest store to address still in the store buffer, NULL for none */
+static const struct BufferedStore* bufferedStore(const struct Cpu* cpu, int address) {
+    const struct StoreBuffer* buffer = &cpu->pipeline.storeBuffer;
+    for (int i = buffer->count - 1; i >= 0; i--) {
+        const struct BufferedStore* store = &buffer->entries[(buffer->head + i) % MAX_STORE_BUFFER];
+        if (store->address == address) return store;
+    }
+    return NULL;
+}
+
+/* The word at address as the program sees it, stores still in the store buffer included */
+static int loadWord(struct Cpu* cpu, int address) {
+    const struct BufferedStore* store = bufferedStore(cpu, address);
+    if (store != NULL) return store->value;
+    return validMemoryAddress(&cpu->memory, address) ? readMemory(&cpu->memory, address) : 0;
+}
+
+/* What an out-of-bounds LW leaves in its register: the value it had before the LW, from an older slot of
+   the group or from the register file, which every older group has written back to by the time the
+   group makes its access. The LW writes that back, so an instruction forwarded from it sees it too. */
+static int unchangedRegister(const struct Cpu* cpu, const struct PipelineGroup* group, int slot) {
+    int reg = group->slots[slot].destination;
+    for (int older = slot - 1; older >= 0; older--)
+        if (group->slots[older].destination == reg) return group->slots[older].result;
+    return cpu->registers[reg];
+}
+
+static void storeWord(struct Cpu* cpu, int address, int value) {
+    writeMemory(&cpu->memory, address, value);
+    invalidatePredecoded(&cpu->predecode, address);
+    if (binaryTraceEnabled) traceMemoryWrite(address, value);
+    // MARK: memory print
+    TRACE_INSTRUCTION("MEM PHASE: memory address '%d' written with value '0x%08X', decimal '%d'\n", address, value, value);
+}
+
+/* Starts the write of the oldest store still waiting for the D-cache, then hands memory every store at
+   the head whose write is done. Without a D-cache a write completes in the cycle it starts. */
+static void drainStoreBuffer(struct Cpu* cpu) {
+    struct StoreBuffer* buffer = &cpu->pipeline.storeBuffer;
+
+    if (buffer->started < buffer->count) {
+        struct BufferedStore* store = &buffer->entries[(buffer->head + buffer->started++) % MAX_STORE_BUFFER];
+        int cycles = cpu->dataCache.config.enabled ? accessCache(&cpu->dataCache, store->pc, store->address, true, cpu->cycle) : 1;
+        store->doneCycle = cpu->cycle + cycles - 1;
+    }
+    while (buffer->started > 0 && buffer->entries[buffer->head].doneCycle <= cpu->cycle) {
+        const struct BufferedStore* store = &buffer->entries[buffer->head];
+        storeWord(cpu, store->address, store->value);
+        buffer->head = (buffer->head + 1) % MAX_STORE_BUFFER;
+        buffer->count--;
+        buffer->started--;
+    }
+}
+
+/* Cycles beyond the first the D-cache takes over the group's access, the pairing rules allowing one,
+   started at the given cycle. With a store buffer a SW leaves the access to the drain and a LW of a
+   buffered word takes it from there. */
+static int dataCacheCycles(struct Cpu* cpu, const struct PipelineGroup* group, int cycle) {
+    int cycles = 0;
+    if (!cpu->dataCache.config.enabled) return 0;
+    for (int slot = 0; slot < group->size; slot++) {
+        const struct PipelineLatch* latch = &group->slots[slot];
+        bool load = latch->fields.opcode == 10;
+        if (!load && latch->fields.opcode != 11) continue;
+        if (cpu->storeBufferEntries > 0 && (!load || bufferedStore(cpu, latch->result) != NULL)) continue;
+        if (validMemoryAddress(&cpu->memory, latch->result))
+            cycles += accessCache(&cpu->dataCache, latch->pc, latch->result, !load, cycle) - 1;
+    }
+    return cycles;
+}
+
+/* Whether the group holds a SW the full store buffer has no room for */
+static bool waitingForStoreBuffer(const struct Cpu* cpu, const struct PipelineGroup* group) {
+    if (cpu->storeBufferEntries == 0 || cpu->pipeline.storeBuffer.count < cpu->storeBufferEntries) return false;
+    for (int slot = 0; slot < group->size; slot++)
+        if (group->slots[slot].fields.opcode == 11 && validMemoryAddress(&cpu->memory, group->slots[slot].result)) return true;
+    return false;
+}
+
+/* When a result leaving its unit this cycle can be forwarded: next cycle from an unpipelined unit, which
+   has already held the stage for its latency, the rest of the latency later from a pipelined one */
+static int readyCycleFor(const struct Cpu* cpu, int unit) {
+    const struct UnitTiming* timing = &cpu->unitTimings[unit];
+    return cpu->cycle + (timing->pipelined ? timing->latency : 1);
+}
+
+/* Squashes the wrong-path instructions behind a mispredicted branch in the given stage and slot: the
+   younger stages and the slots after it in its own group */
+static void flushPipeline(struct Cpu* cpu, int resolvingStage, int resolvingSlot) {
+    struct PipelineGroup* group = &cpu->pipeline.stages[resolvingStage];
+
+    for (int stage = 0; stage < resolvingStage; stage++) {
+        cpu->counters.squashedInstructions += cpu->pipeline.stages[stage].size;
+        cpu->pipeline.stages[stage].size = 0;
+    }
+    cpu->counters.squashedInstructions += group->size - resolvingSlot - 1;
+    group->size = resolvingSlot + 1;
+    TRACE_INSTRUCTION("\033[1;35m--- HAZARD DETECTED, FLUSHING PIPELINE ---\033[0m\n");
+}
+
+/* Whether a store by the given stage and slot overwrote a word a younger instruction was already fetched
+   from: one after it in its own group or in an earlier stage */
+static bool storeHitsFetched(const struct Cpu* cpu, int storeStage, int storeSlot, int address) {
+    for (int stage = storeStage; stage >= 0; stage--) {
+        const struct PipelineGroup* group = &cpu->pipeline.stages[stage];
+        for (int slot = stage == storeStage ? storeSlot + 1 : 0; slot < group->size; slot++)
+            if (group->slots[slot].pc == address) return true;
+    }
+    return false;
+}
+
+/* Whether the result of the producer in the given stage is on a bypass path yet: an ALU result once it
+   has left the last EX stage, loaded data only from the WB latch, and either only once its unit's
+   latency is over */
+static bool bypassable(const struct Cpu* cpu, const struct StageLayout* layout, int stage, const struct PipelineLatch* producer) {
+    if (producer->readyCycle > cpu->cycle) return false;
+    if (opcodeOf(producer->instruction) == 10) return stage == layout->writeback;
+    return stage > layout->lastExecute;
+}
+
+static bool writesSource(const struct PipelineLatch* producer, const struct DecodedInstructionFields* fields, int mask) {
+    int destination = producer->destination;
+    return destination != 0 && (((mask & READS_R1) && fields->r1 == destination) ||
+        ((mask & READS_R2) && fields->r2 == destination) || ((mask & READS_R3) && fields->r3 == destination));
+}
+
+/* Without forwarding an instruction leaves ID only once every older instruction writing one of its
+   sources has written back. WB writes before ID reads in a cycle, so WB itself never holds one. */
+static bool waitingForWriteback(const struct Cpu* cpu, const struct StageLayout* layout, const struct PipelineLatch* latch) {
+    int mask = operandMask(latch->fields.opcode);
+    for (int stage = layout->firstExecute; stage < layout->writeback; stage++) {
+        const struct PipelineGroup* group = &cpu->pipeline.stages[stage];
+        for (int slot = 0; slot < group->size; slot++)
+            if (writesSource(&group->slots[slot], &latch->fields, mask)) return true;
+    }
+    return false;
+}
+
+/* Pairing rules: how many instructions at the head of the ID group go to EX together. One stays behind,
+   with everything after it, when an older one in the group writes one of its sources, when it would be
+   the group's second LW/SW or when it follows a BNE or J; without forwarding also while it waits for a
+   write-back. */
+static int pairInstructions(const struct Cpu* cpu, const struct StageLayout* layout, struct PipelineGroup* group) {
+    int memoryAccesses = 0;
+
+    for (int slot = 0; slot < group->size; slot++) {
+        const struct PipelineLatch* latch = &group->slots[slot];
+        int mask = operandMask(latch->fields.opcode);
+
+        group->issueLimit = ISSUE_LIMIT_DEPENDENCE;
+        if (!cpu->forwarding && waitingForWriteback(cpu, layout, latch)) return slot;
+        for (int older = 0; older < slot; older++)
+            if (writesSource(&group->slots[older], &latch->fields, mask)) return slot;
+        group->issueLimit = ISSUE_LIMIT_BRANCH;
+        if (slot > 0 && isBranchOrJump(group->slots[slot - 1].fields.opcode)) return slot;
+        group->issueLimit = ISSUE_LIMIT_MEMORY;
+        if ((latch->fields.opcode == 10 || latch->fields.opcode == 11) && memoryAccesses++ > 0) return slot;
+    }
+    return group->size;
+}
+
+/* One operand through the forwarding unit. Every latch past the first EX stage feeds a bypass path,
+   EX/MEM and MEM/WB in the 5-stage pipeline, one per issue slot, and the youngest producer of the
+   register wins. Returns false while that producer's result is not on its path yet. */
+static bool forwardOperand(const struct Cpu* cpu, const struct StageLayout* layout, int reg, int* value, int* forwarded) {
+    if (reg == 0) return true;
+    for (int stage = layout->firstExecute + 1; stage <= layout->writeback; stage++) {
+        const struct PipelineGroup* group = &cpu->pipeline.stages[stage];
+        for (int slot = group->size - 1; slot >= 0; slot--) {
+            const struct PipelineLatch* producer = &group->slots[slot];
+            if (producer->destination != reg) continue;
+            if (!bypassable(cpu, layout, stage, producer)) return false;
+            *value = producer->result;
+            (*forwarded)++;
+            return true;
+        }
+    }
+    return true;
+}
+
+/* Runs on every cycle an instruction spends in the first EX stage, so a producer that passes over a
+   bypass path while it is there is not missed. Returns false while an operand is not ready. */
+static bool forwardOperands(const struct Cpu* cpu, const struct StageLayout* layout, struct PipelineLatch* latch,
+                            int* forwarded) {
+    struct DecodedInstructionFields* fields = &latch->fields;
+    int mask = operandMask(fields->opcode);
+    bool ready = true;
+
+    if (mask & READS_R1) ready &= forwardOperand(cpu, layout, fields->r1, &fields->r1val, forwarded);
+    if (mask & READS_R2) ready &= forwardOperand(cpu, layout, fields->r2, &fields->r2val, forwarded);
+    if (mask & READS_R3) ready &= forwardOperand(cpu, layout, fields->r3, &fields->r3val, forwarded);
+    return ready;
+}
+
+/* An operand waits on a load when its producer is a LW, otherwise on a result still in EX or in a unit */
+static bool waitingOnLoad(const struct Cpu* cpu, const struct StageLayout* layout, const struct PipelineLatch* latch) {
+    int mask = operandMask(latch->fields.opcode);
+    for (int stage = layout->firstExecute + 1; stage <= layout->writeback; stage++) {
+        const struct PipelineGroup* group = &cpu->pipeline.stages[stage];
+        for (int slot = group->size - 1; slot >= 0; slot--) {
+            const struct PipelineLatch* producer = &group->slots[slot];
+            if (writesSource(producer, &latch->fields, mask) && !bypassable(cpu, layout, stage, producer))
+                return opcodeOf(producer->instruction) == 10;
+        }
+    }
+    return false;
+}
+
+/* Compares the next PC IF predicted for the instruction in the given stage and slot with the resolved
+   one, trains the predictor and on a mismatch squashes the wrong-path instructions and refetches from
+   the right PC */
+static void resolveNextPC(struct Cpu* cpu, int stage, int slot, bool taken, int target) {
+    struct PipelineLatch* latch = &cpu->pipeline.stages[stage].slots[slot];
+    struct BranchPrediction* prediction = &latch->prediction;
+    int opcode = latch->fields.opcode;
+    bool isBranch = isBranchOrJump(opcode);
+    int nextPC = taken ? target : latch->pc + 1;
+    int predictedPC = prediction->taken ? prediction->target : latch->pc + 1;
+
+    prediction->resolved = true;
+    if (isBranch || prediction->targetKnown)
+        updateBranchPredictor(&cpu->predictor, prediction, latch->pc, isBranch, opcode == 7, taken, target);
+    if (nextPC == predictedPC) return;
+
+    if (opcode == 4) cpu->counters.flushesBne++;
+    if (opcode == 7) cpu->counters.flushesJump++;
+    flushPipeline(cpu, stage, slot);
+    cpu->programCounter = nextPC;
+}
+
+/* Bypass into the ID comparator, from the ALU output of the last EX stage once it has its result or
+   from a later latch. A BNE waiting on a load, on an instruction still executing or on an older one in
+   its own ID group is left to resolve later. */
+static bool forwardIntoDecode(const struct Cpu* cpu, const struct StageLayout* layout, int slot, int reg, int* value,
+                              int* forwarded) {
+    const struct Pipeline* pipeline = &cpu->pipeline;
+    if (reg == 0) return true;
+    for (int older = 0; older < slot; older++)
+        if (pipeline->stages[1].slots[older].destination == reg) return false;
+
+    for (int stage = layout->firstExecute; stage < layout->writeback; stage++) {
+        const struct PipelineGroup* group = &pipeline->stages[stage];
+        for (int i = group->size - 1; i >= 0; i--) {
+            const struct PipelineLatch* producer = &group->slots[i];
+            if (producer->destination != reg) continue;
+            bool computed = stage == layout->lastExecute && group->cyclesRemaining == 0 && opcodeOf(producer->instruction) != 10 &&
+                producer->readyCycle <= cpu->cycle + 1;
+            if (!computed && !bypassable(cpu, layout, stage, producer)) return false;
+            *value = producer->result;
+            (*forwarded)++;
+            return true;
+        }
+    }
+    return true;
+}
+
+/* Whether an instruction between ID and writeback still has its next PC to resolve, so ID would be
+   resolving on a path it may yet squash */
+static bool olderUnresolved(const struct Cpu* cpu, const struct StageLayout* layout) {
+    for (int stage = layout->firstExecute; stage < layout->writeback; stage++) {
+        const struct PipelineGroup* group = &cpu->pipeline.stages[stage];
+        for (int slot = 0; slot < group->size; slot++)
+            if (!group->slots[slot].prediction.resolved) return true;
+    }
+    return false;
+}
+
+/* Comparator in ID, for --resolve-stage id */
+static void resolveInDecode(struct Cpu* cpu, const struct StageLayout* layout, int slot) {
+    struct PipelineLatch* latch = &cpu->pipeline.stages[1].slots[slot];
+    const struct DecodedInstructionFields* fields = &latch->fields;
+    int r1val = fields->r1val, r2val = fields->r2val;
+    int forwarded = 0;
+    bool taken = false;
+    int target = 0;
+
+    if (fields->opcode == 4) { //BNE
+        if (!forwardIntoDecode(cpu, layout, slot, fields->r1, &r1val, &forwarded) ||
+            !forwardIntoDecode(cpu, layout, slot, fields->r2, &r2val, &forwarded)) return;
+        cpu->counters.forwardedOperands += forwarded;
+        taken = r1val != r2val;
+        target = latch->pc + 1 + fields->immediate;
+    } else if (fields->opcode == 7) { //J
+        taken = true;
+        target = (latch->pc & 0xF0000000) | fields->address;
+    }
+    resolveNextPC(cpu, 1, slot, taken, target);
+}
+
+/* Fetches up to the issue width of consecutive words, ending the group after a predicted-taken branch */
+static void fetch(struct Cpu* cpu) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct PipelineGroup* group = &pipeline->stages[0];
+    // The program occupies [0, lineCount) of the instruction region; a PC outside it ends fetching
+    bool inProgram = cpu->programCounter >= 0 && cpu->programCounter < cpu->lineCount;
+
+    // The instruction port is IF's alone, so it fetches on every cycle ID has taken the last group
+    if (cpu->memoryPorts == MEMORY_SPLIT_PORTS) pipeline->fetchReady = true;
+
+    // A group whose line the I-cache is still filling stays in IF
+    if (group->size > 0 && group->cyclesRemaining > 0) {
+        group->cyclesRemaining--;
+        cpu->counters.stallCycles[STALL_INSTRUCTION_CACHE]++;
+        return;
+    }
+
+    if (pipeline->fetchReady && inProgram && group->size == 0) {
+        group->cyclesRemaining = 0;
+        while (group->size < cpu->issueWidth && cpu->programCounter >= 0 && cpu->programCounter < cpu->lineCount) {
+            struct PipelineLatch* latch = &group->slots[group->size];
+            latch->instruction = loadWord(cpu, cpu->programCounter);
+            latch->pc = cpu->programCounter;
+            if (cpu->instructionCache.config.enabled) {
+                int cycles = accessCache(&cpu->instructionCache, cpu->programCounter, cpu->programCounter, false, cpu->cycle);
+                if (cycles - 1 > group->cyclesRemaining) group->cyclesRemaining = cycles - 1;
+            }
+            latch->prediction = predictBranch(&cpu->predictor, cpu->programCounter);
+            cpu->programCounter = latch->prediction.taken ? latch->prediction.target : cpu->programCounter + 1;
+            if (latch->instruction == 0) break; // A zero word is a bubble, and ends the group
+            group->size++;
+            if (latch->prediction.taken) break;
+        }
+        pipeline->fetchReady = false;
+    }else {
+        if (inProgram && !pipeline->fetchReady)
+            cpu->counters.stallCycles[STALL_FETCH_SLOT]++;
+        pipeline->fetchReady = true;
+    }
+}
+
+static void decode(struct Cpu* cpu, const struct StageLayout* layout) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct PipelineGroup* group = &pipeline->stages[1];
+
+    pullGroup(&pipeline->stages[0], group, layout->decodeCycles, pipeline->stages[0].size);
+    if (group->size == 0) return;
+    if (group->cyclesRemaining > 0 && --group->cyclesRemaining > 0) return;
+
+    // Decoded on its last cycle, then again on every cycle it waits for EX so the register reads stay current
+    for (int slot = 0; slot < group->size; slot++) {
+        struct PipelineLatch* latch = &group->slots[slot];
+        latch->fields = *predecodedFor(&cpu->predecode, latch->pc, latch->instruction);
+        latch->fields.r1val = cpu->registers[latch->fields.r1];
+        latch->fields.r2val = cpu->registers[latch->fields.r2];
+        latch->fields.r3val = cpu->registers[latch->fields.r3];
+        latch->destination = destinationOf(&latch->fields);
+    }
+
+    group->issueCount = pairInstructions(cpu, layout, group);
+    if (group->issueCount == 0) {
+        group->cyclesRemaining = 1;
+        cpu->counters.stallCycles[STALL_DATA_HAZARD]++;
+        return;
+    }
+    if (cpu->resolveStage != RESOLVE_IN_DECODE || olderUnresolved(cpu, layout)) return;
+    // In order: a slot left for EX keeps the ones after it from resolving ahead of it
+    for (int slot = 0; slot < group->size; slot++) {
+        if (!group->slots[slot].prediction.resolved) resolveInDecode(cpu, layout, slot);
+        if (!group->slots[slot].prediction.resolved) break;
+    }
+    if (group->issueCount > group->size) group->issueCount = group->size; // A flush dropped the slots after a branch
+}
+
+static void executeInstruction(struct Cpu* cpu, struct PipelineLatch* latch) {
+    struct DecodedInstructionFields* fields = &latch->fields;
+
+    latch->taken = false;
+    switch (fields->opcode) {
+        case 0: //ADD
+            latch->result = fields->r2val + fields->r3val;
+            TRACE_INSTRUCTION("\nExecuted %d = %d + %d\n", latch->result, fields->r2val, fields->r3val);
+            break;
+        case 1: //SUB
+            latch->result = fields->r2val - fields->r3val;
+            TRACE_INSTRUCTION("\nExecuted %d = %d - %d\n", latch->result, fields->r2val, fields->r3val);
+            break;
+        case 2: //MULI
+            latch->result = fields->r2val * fields->immediate;
+            TRACE_INSTRUCTION("\nExecuted %d = %d * %d\n", latch->result, fields->r2val, fields->immediate);
+            break;
+        case 3: //ADDI
+            latch->result = fields->r2val + fields->immediate;
+            TRACE_INSTRUCTION("\nExecuted %d = %d + %d\n", latch->result, fields->r2val, fields->immediate);
+            break;
+        case 4: //BNE
+            latch->result = latch->pc + 1 + fields->immediate;
+            latch->taken = fields->r1val != fields->r2val;
+            if (latch->taken)
+                TRACE_INSTRUCTION("\nBNE Executed %d = 1 + %d + %d\n", latch->result, latch->pc, fields->immediate);
+            break;
+        case 5: //ANDI
+            latch->result = fields->r2val & fields->immediate;
+            TRACE_INSTRUCTION("\nExecuted %d = %d AND %d\n", latch->result, fields->r2val, fields->immediate);
+            break;
+        case 6: //ORI
+            latch->result = fields->r2val | fields->immediate;
+            TRACE_INSTRUCTION("\nExecuted %d = %d OR %d\n", latch->result, fields->r2val, fields->immediate);
+            break;
+        case 7: //J
+            latch->result = (latch->pc & 0xF0000000) | fields->address;
+            latch->taken = true;
+            TRACE_INSTRUCTION("\nExecuted PC = %d CONCAT %d\n", (latch->pc & 0xF0000000), fields->address);
+            break;
+        case 8: //SLL
+            latch->result = fields->r2val << fields->shamt;
+            TRACE_INSTRUCTION("\nExecuted %d = %d SHIFT LEFT %d\n", latch->result, fields->r2val, fields->shamt);
+            break;
+        case 9: //SRL
+            latch->result = fields->r2val >> fields->shamt;
+            TRACE_INSTRUCTION("\nExecuted %d = %d SHIFT RIGHT %d\n", latch->result, fields->r2val, fields->shamt);
+            break;
+        case 10: //LW
+        case 11: //SW
+            latch->result = fields->r2val + fields->immediate;
+            TRACE_INSTRUCTION("\nExecuted %d = %d + %d + %d\n", latch->result, fields->r2val, fields->immediate, cpu->memory.dataOffset);
+            break;
+        default:
+            break;
+    }
+}
+
+static void execute(struct Cpu* cpu, const struct StageLayout* layout, int stage) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct PipelineGroup* group = &pipeline->stages[stage];
+    struct PipelineGroup* previous = &pipeline->stages[stage - 1];
+    bool first = stage == layout->firstExecute;
+    int forwarded = 0;
+    bool ready = true;
+
+    if (!first) {
+        pullGroup(previous, group, 1, previous->size);
+    } else if (pullGroup(previous, group, layout->executeCycles, previous->issueCount)) {
+        cpu->counters.issueGroups[group->size]++;
+        if (previous->size > 0) cpu->counters.issueLimits[previous->issueLimit]++;
+        previous->issueCount = 0;
+    }
+    if (group->size == 0 || group->cyclesRemaining == 0) return;
+
+    if (first && cpu->forwarding && !group->unitBusy)
+        for (int slot = 0; slot < group->size; slot++)
+            ready &= forwardOperands(cpu, layout, &group->slots[slot], &forwarded);
+    if (group->unitBusy) cpu->counters.stallCycles[STALL_UNIT_LATENCY]++;
+    if (--group->cyclesRemaining > 0) return;
+
+    if (!group->unitBusy) {
+        // Interlock: the group waits a cycle at a time until every operand it needs is on a bypass path,
+        // one bubble for a load in the 5-stage pipeline
+        if (!ready) {
+            bool load = false;
+            for (int slot = 0; slot < group->size; slot++)
+                load |= waitingOnLoad(cpu, layout, &group->slots[slot]);
+            group->cyclesRemaining = 1;
+            cpu->counters.stallCycles[load ? STALL_LOAD_USE : STALL_EXECUTE_LATENCY]++;
+            return;
+        }
+        cpu->counters.forwardedOperands += forwarded;
+        if (stage != layout->lastExecute) return;
+
+        // An unpipelined unit keeps the group, and everything behind it, for its whole latency
+        if ((group->cyclesRemaining = unpipelinedCycles(cpu, group, false)) > 0) {
+            group->unitBusy = true;
+            return;
+        }
+    }
+    group->unitBusy = false;
+
+    // A mispredicted branch drops the slots after it, which ends the loop
+    for (int slot = 0; slot < group->size; slot++) {
+        struct PipelineLatch* latch = &group->slots[slot];
+        executeInstruction(cpu, latch);
+        latch->readyCycle = readyCycleFor(cpu, stageUnitFor(latch->fields.opcode, false));
+        if (cpu->resolveStage != RESOLVE_IN_MEMORY && !latch->prediction.resolved)
+            resolveNextPC(cpu, stage, slot, latch->taken, latch->result);
+    }
+}
+
+static void memory(struct Cpu* cpu, const struct StageLayout* layout, int stage) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct PipelineGroup* group = &pipeline->stages[stage];
+
+    pullGroup(&pipeline->stages[stage - 1], group, 1, pipeline->stages[stage - 1].size);
+    if (group->size == 0 || group->cyclesRemaining == 0) return;
+    if (--group->cyclesRemaining > 0 || stage != layout->lastMemory) return;
+
+    if (!group->unitBusy) {
+        for (int slot = 0; slot < group->size; slot++)
+            if (cpu->resolveStage == RESOLVE_IN_MEMORY && !group->slots[slot].prediction.resolved)
+                resolveNextPC(cpu, stage, slot, group->slots[slot].taken, group->slots[slot].result);
+        if (waitingForStoreBuffer(cpu, group)) {
+            group->cyclesRemaining = 1;
+            cpu->counters.stallCycles[STALL_STORE_BUFFER]++;
+            return;
+        }
+        // The access takes place once an unpipelined load/store unit has spent its latency on it and the
+        // D-cache has served it
+        int unitCycles = unpipelinedCycles(cpu, group, true);
+        int cacheCycles = dataCacheCycles(cpu, group, cpu->cycle + unitCycles);
+        cpu->counters.stallCycles[STALL_UNIT_LATENCY] += unitCycles;
+        cpu->counters.stallCycles[STALL_DATA_CACHE] += cacheCycles;
+        if ((group->cyclesRemaining = unitCycles + cacheCycles) > 0) {
+            group->unitBusy = true;
+            return;
+        }
+    }
+    group->unitBusy = false;
+
+    for (int slot = 0; slot < group->size; slot++) {
+        struct PipelineLatch* latch = &group->slots[slot];
+
+        if (latch->fields.opcode == 10) { //LW
+            bool valid = validMemoryAddress(&cpu->memory, latch->result);
+            cpu->counters.loads++;
+            if (bufferedStore(cpu, latch->result) != NULL) cpu->counters.storeForwards++;
+            else if (!valid) reportMemoryAccessError(latch->pc, latch->result);
+            latch->result = valid ? loadWord(cpu, latch->result) : unchangedRegister(cpu, group, slot);
+            latch->readyCycle = readyCycleFor(cpu, UNIT_LOAD_STORE);
+        } else if (latch->fields.opcode == 11) { //SW
+            cpu->counters.stores++;
+            if (!validMemoryAddress(&cpu->memory, latch->result)) {
+                reportMemoryAccessError(latch->pc, latch->result);
+                continue;
+            }
+            struct StoreBuffer* buffer = &pipeline->storeBuffer;
+            if (cpu->storeBufferEntries > 0)
+                buffer->entries[(buffer->head + buffer->count++) % MAX_STORE_BUFFER] =
+                    (struct BufferedStore){ latch->result, latch->fields.r1val, latch->pc, 0 };
+            else
+                storeWord(cpu, latch->result, latch->fields.r1val);
+            // Self-modifying code: IF reads through the store buffer, so only what was fetched before this
+            // store is stale, and it is refetched like the wrong path of a branch
+            if (storeHitsFetched(cpu, stage, slot, latch->result)) {
+                flushPipeline(cpu, stage, slot);
+                cpu->programCounter = latch->pc + 1;
+            }
+        }
+    }
+}
+
+
+/* Instructions complete in order, so a finished group whose pipelined unit has not delivered a result
+   yet stays in the last MEM stage until it has */
+static bool resultsReady(const struct Cpu* cpu, const struct PipelineGroup* group) {
+    if (group->size == 0 || group->cyclesRemaining != 0) return true;
+    for (int slot = 0; slot < group->size; slot++)
+        if (group->slots[slot].readyCycle > cpu->cycle) return false;
+    return true;
+}
+
+static void writeback(struct Cpu* cpu, const struct StageLayout* layout) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    struct PipelineGroup* group = &pipeline->stages[layout->writeback];
+    struct PipelineGroup* last = &pipeline->stages[layout->lastMemory];
+
+    group->size = 0; // Retired last cycle
+    if (!resultsReady(cpu, last)) {
+        cpu->counters.stallCycles[STALL_UNIT_LATENCY]++;
+        return;
+    }
+    pullGroup(last, group, 0, last->size);
+
+    // In program order, so the younger of two writes to a register in one group wins
+    for (int slot = 0; slot < group->size; slot++) {
+        const struct PipelineLatch* latch = &group->slots[slot];
+        cpu->counters.instructionsRetired++;
+        cpu->counters.retiredByOpcode[opcodeOf(latch->instruction)]++;
+        // Counted here, so a wrong-path BNE/J squashed after it executed is not
+        if (latch->fields.opcode == 4) cpu->counters.branches++;
+        if (latch->fields.opcode == 7) cpu->counters.jumps++;
+        if (latch->destination != 0) {
+            cpu->registers[latch->destination] = latch->result;
+            if (binaryTraceEnabled) traceRegisterWrite(latch->destination, latch->result);
+            //MARK: REG print
+            TRACE_INSTRUCTION("\nWB PHASE: R%d set to %d\n", latch->destination, latch->result);
+        }
+    }
+    cpu->registers[0] = 0;
+}
+
+static void printRegistersMinimal(struct Cpu* cpu) {
+
+
+    for (int i =0; i < REGISTER_COUNT; i++) {
+        printf("\033[1;32mR%d: %d ", i, cpu->registers[i]);
+        printf(" ");
+        if (i == 15) printf("\n");
+    }
+    printf("\n\033[0m");
+
+}
+
+static void printPipeline(struct Cpu* cpu) {
+    struct Pipeline* pipeline = &cpu->pipeline;
+    printf("  PC: %d\n", cpu->programCounter-1);
+    printf("\033[1;34m");
+    int width = 5; // "MEM: ", or wider so the split stages line up
+    for (int stage = 0; stage < cpu->pipelineDepth; stage++)
+        if ((int)strlen(pipelineStageName(cpu, stage)) + 2 > width) width = strlen(pipelineStageName(cpu, stage)) + 2;
+    for (int stage = 0; stage < cpu->pipelineDepth; stage++) {
+        const struct PipelineGroup* group = &pipeline->stages[stage];
+        char label[BINARY_TRACE_STAGE_NAME + 1];
+        snprintf(label, sizeof(label), "%s:", pipelineStageName(cpu, stage));
+        printf("  %-*s", width, label);
+        // The issue slots side by side, "-" for an empty one
+        for (int slot = 0; slot < cpu->issueWidth; slot++) {
+            if (slot > 0) printf(" | ");
+            printf("%s", slot < group->size ? getInstructionTextAt(cpu, group->slots[slot].pc, group->slots[slot].instruction) : "-");
+        }
+        printf("\n");
+    }
+    printf("\033[0m");
+}
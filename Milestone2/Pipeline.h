@@ -0,0 +1,17 @@
+#pragma once
+#include "Cpu.h"
+#include "BinaryTrace.h"
+
+/* Cycle-level model of the pipeline, cpu->pipelineDepth stages deep, with per-cycle tracing */
+void runPipeline(struct Cpu* cpu); // Advances every stage by one cycle
+bool pipelineDone(const struct Cpu* cpu);
+int runPipelineToCompletion(struct Cpu* cpu); // Steps until the pipeline drains, returns the number of cycles taken
+int runPipelineUntil(struct Cpu* cpu, long long cycleLimit, long long instructionLimit); // Or stops at a limit, see runLimitReached
+
+const char* resolveStageName(enum ResolveStage stage);
+int parseResolveStage(const char* name); // "id", "ex" or "mem", -1 for anything else
+const char* memoryPortsName(enum MemoryPorts ports);
+int parseMemoryPorts(const char* name); // "shared" or "split", -1 for anything else
+
+const char* pipelineStageName(const struct Cpu* cpu, int stage); // "IF", "ID", "EX" or "EX1".., "MEM" or "MEM1".., "WB"
+void pipelineTraceLayout(const struct Cpu* cpu, struct BinaryTraceLayout* layout); // Stage names for openBinaryTrace
@@ -0,0 +1,117 @@
+#include "Predecode.h"
+#include "Memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+void decodeInstructionWord(int instruction, struct DecodedInstructionFields* fields) {
+    fields->opcode     = (instruction >> 28) & 0xF;
+    fields->r1         = (instruction >> 23) & 0x1F;
+    fields->r2         = (instruction >> 18) & 0x1F;
+    fields->r3         = (instruction >> 13) & 0x1F;
+    fields->shamt      = instruction & 0x1FFF;
+    fields->immediate  = instruction & 0x3FFFF;
+    if ((fields->immediate & 0x20000) >> 17 == 1)
+        fields->immediate |= 0xFFFC0000; // Make it negative
+    fields->address    = instruction & 0xFFFFFFF;
+    fields->r1val = 0;
+    fields->r2val = 0;
+    fields->r3val = 0;
+}
+
+void disassembleInstruction(const struct DecodedInstructionFields* fields, char* buffer) {
+    int r1 = fields->r1, r2 = fields->r2, r3 = fields->r3;
+    int imm = fields->immediate;
+
+    switch(fields->opcode) {
+        case 0:  // ADD
+            sprintf(buffer, "ADD R%d R%d R%d", r1, r2, r3);
+            break;
+        case 1:  // SUB
+            sprintf(buffer, "SUB R%d R%d R%d", r1, r2, r3);
+            break;
+        case 2:  // MULI
+            sprintf(buffer, "MULI R%d R%d %d", r1, r2, imm);
+            break;
+        case 3:  // ADDI
+            sprintf(buffer, "ADDI R%d R%d %d", r1, r2, imm);
+            break;
+        case 4:  // BNE
+            sprintf(buffer, "BNE R%d R%d %d", r1, r2, imm);
+            break;
+        case 5:  // ANDI
+            sprintf(buffer, "ANDI R%d R%d %d", r1, r2, imm);
+            break;
+        case 6:  // ORI
+            sprintf(buffer, "ORI R%d R%d %d", r1, r2, imm);
+            break;
+        case 7:  // J
+            sprintf(buffer, "J %d", fields->address);
+            break;
+        case 8:  // SLL
+            sprintf(buffer, "SLL R%d R%d %d", r1, r2, fields->shamt);
+            break;
+        case 9:  // SRL
+            sprintf(buffer, "SRL R%d R%d %d", r1, r2, fields->shamt);
+            break;
+        case 10: // LW
+            sprintf(buffer, "LW R%d R%d %d", r1, r2, imm);
+            break;
+        case 11: // SW
+            sprintf(buffer, "SW R%d R%d %d", r1, r2, imm);
+            break;
+        default:
+            sprintf(buffer, "UNKNOWN");
+            break;
+    }
+}
+
+void buildPredecodeTable(struct PredecodeTable* table, struct Memory* memory, int instructionCount) {
+    free(table->entries);
+    table->entries = malloc((instructionCount > 0 ? instructionCount : 1) * sizeof(struct PredecodedInstruction));
+    table->size = instructionCount;
+    table->memory = memory;
+
+    for (int pc = 0; pc < instructionCount; pc++) {
+        table->entries[pc].instruction = readMemory(memory, pc);
+        decodeInstructionWord(table->entries[pc].instruction, &table->entries[pc].fields);
+        table->entries[pc].handler = NULL;
+        table->entries[pc].threadedLabel = NULL;
+        table->entries[pc].valid = true;
+    }
+}
+
+void freePredecodeTable(struct PredecodeTable* table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->size = 0;
+}
+
+void invalidatePredecoded(struct PredecodeTable* table, int address) {
+    if (address >= 0 && address < table->size)
+        table->entries[address].valid = false;
+}
+
+/* Returns the decoded fields of the word fetched from pc. An in-flight word can be older than memory
+   after a store into the instruction region, so the cached entry is only used when the words match. */
+const struct DecodedInstructionFields* predecodedFor(struct PredecodeTable* table, int pc, int instruction) {
+    if (pc < 0 || pc >= table->size) {
+        decodeInstructionWord(instruction, &table->scratchFields);
+        return &table->scratchFields;
+    }
+
+    struct PredecodedInstruction* entry = &table->entries[pc];
+    if (!entry->valid || entry->instruction != instruction) {
+        entry->instruction = instruction;
+        decodeInstructionWord(instruction, &entry->fields);
+        entry->handler = NULL;
+        entry->threadedLabel = NULL;
+        entry->valid = true;
+    }
+    return &entry->fields;
+}
+
+struct PredecodedInstruction* refreshPredecoded(struct PredecodeTable* table, int pc) {
+    predecodedFor(table, pc, readMemory(table->memory, pc));
+    return &table->entries[pc];
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Simulator.h"
+#include "Memory.h"
+
+struct Cpu;
+typedef int (*InstructionHandler)(struct Cpu* cpu, const struct DecodedInstructionFields* fields, int pc); // Returns the next PC
+
+struct PredecodedInstruction {
+    int instruction; // Raw word the fields were decoded from
+    bool valid;
+    struct DecodedInstructionFields fields;
+    InstructionHandler handler; // Dispatch targets attached by the execution engine, cleared on re-decode
+    const void* threadedLabel;
+};
+
+struct PredecodeTable {
+    struct PredecodedInstruction* entries; // One entry per program instruction
+    int size;
+    struct Memory* memory; // Where invalidated entries are re-read from
+    struct DecodedInstructionFields scratchFields; // For words outside the instruction region
+};
+
+void decodeInstructionWord(int instruction, struct DecodedInstructionFields* fields);
+void disassembleInstruction(const struct DecodedInstructionFields* fields, char* buffer);
+
+void buildPredecodeTable(struct PredecodeTable* table, struct Memory* memory, int instructionCount); // Decodes every program word once, indexed by PC
+void freePredecodeTable(struct PredecodeTable* table);
+void invalidatePredecoded(struct PredecodeTable* table, int address); // Called when a store writes into the instruction region
+const struct DecodedInstructionFields* predecodedFor(struct PredecodeTable* table, int pc, int instruction);
+struct PredecodedInstruction* refreshPredecoded(struct PredecodeTable* table, int pc);
+
+/* Fast path for execution engines fetching inside the program; pc must be below its instruction count */
+static inline struct PredecodedInstruction* predecodedEntryAt(struct PredecodeTable* table, int pc) {
+    struct PredecodedInstruction* entry = &table->entries[pc];
+    return entry->valid ? entry : refreshPredecoded(table, pc);
+}
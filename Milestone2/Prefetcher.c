@@ -0,0 +1,188 @@
+#include "Prefetcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CONFIDENCE 3
+#define PREDICT_CONFIDENCE 2
+#define STREAM_WINDOW 4 // Lines either side of a stream's last one that still continue it
+
+void initPrefetcherConfig(struct PrefetcherConfig* config) {
+    config->kind = PREFETCH_NONE;
+    config->degree = 2;
+    config->distance = 1;
+    config->tableEntries = 16;
+}
+
+const char* prefetcherKindName(enum PrefetcherKind kind) {
+    switch (kind) {
+        case PREFETCH_NONE:      return "none";
+        case PREFETCH_NEXT_LINE: return "next-line";
+        case PREFETCH_STRIDE:    return "stride";
+        case PREFETCH_STREAM:    return "stream";
+        default:                 return "unknown";
+    }
+}
+
+static int* settingField(struct PrefetcherConfig* config, const char* key, int* maximum) {
+    *maximum = MAX_PREFETCH_DEGREE;
+    if (strcmp(key, "degree") == 0) return &config->degree;
+    *maximum = MAX_PREFETCH_DISTANCE;
+    if (strcmp(key, "distance") == 0) return &config->distance;
+    *maximum = MAX_PREFETCH_TABLE;
+    if (strcmp(key, "table") == 0) return &config->tableEntries;
+    return NULL;
+}
+
+static bool applySetting(struct PrefetcherConfig* config, const char* key, const char* text) {
+    int maximum;
+    char* end;
+    int* field = settingField(config, key, &maximum);
+
+    if (field == NULL) {
+        printf("Unknown prefetcher setting: %s\n", key);
+        return false;
+    }
+    long value = strtol(text, &end, 10);
+    bool powerOfTwo = field == &config->tableEntries;
+    if (*end != '\0' || value < 1 || value > maximum || (powerOfTwo && (value & (value - 1)) != 0)) {
+        printf("Prefetcher setting %s must be %s1 to %d: %s\n", key, powerOfTwo ? "a power of two from " : "", maximum, text);
+        return false;
+    }
+    *field = (int)value;
+    return true;
+}
+
+bool parsePrefetcherConfig(struct PrefetcherConfig* config, const char* settings) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+
+    char* kind = strtok(buffer, ",");
+    if (kind != NULL && strcmp(kind, "next-line") == 0) config->kind = PREFETCH_NEXT_LINE;
+    else if (kind != NULL && strcmp(kind, "stride") == 0) config->kind = PREFETCH_STRIDE;
+    else if (kind != NULL && strcmp(kind, "stream") == 0) config->kind = PREFETCH_STREAM;
+    else {
+        printf("Unknown prefetcher: %s\n", kind != NULL ? kind : settings);
+        return false;
+    }
+    for (char* setting = strtok(NULL, ","); setting != NULL; setting = strtok(NULL, ",")) {
+        char* separator = strchr(setting, '=');
+        if (separator == NULL) {
+            printf("Prefetcher settings are key=value pairs: %s\n", setting);
+            return false;
+        }
+        *separator = '\0';
+        if (!applySetting(config, setting, separator + 1)) return false;
+    }
+    return true;
+}
+
+void configurePrefetcher(struct Prefetcher* prefetcher, const struct PrefetcherConfig* config, int lineWords,
+                         struct PrefetchCounters* counters) {
+    freePrefetcher(prefetcher);
+    prefetcher->config = *config;
+    prefetcher->lineWords = lineWords;
+    prefetcher->counters = counters;
+    if (config->kind == PREFETCH_STRIDE || config->kind == PREFETCH_STREAM)
+        prefetcher->entries = malloc(config->tableEntries * sizeof(struct PrefetchEntry));
+    resetPrefetcher(prefetcher);
+}
+
+void resetPrefetcher(struct Prefetcher* prefetcher) {
+    if (prefetcher->entries != NULL) memset(prefetcher->entries, 0, prefetcher->config.tableEntries * sizeof(struct PrefetchEntry));
+    prefetcher->useClock = 0;
+}
+
+void freePrefetcher(struct Prefetcher* prefetcher) {
+    free(prefetcher->entries);
+    prefetcher->entries = NULL;
+}
+
+/* Tagged next-line: a miss, or the first use of a line it brought in, asks for the lines after it */
+static int predictNextLine(const struct Prefetcher* prefetcher, uint32_t address, bool triggered, uint32_t* lines) {
+    const struct PrefetcherConfig* config = &prefetcher->config;
+    uint32_t line = address & ~(uint32_t)(prefetcher->lineWords - 1);
+
+    if (!triggered) return 0;
+    for (int i = 0; i < config->degree; i++)
+        lines[i] = line + (uint32_t)((config->distance + i) * prefetcher->lineWords);
+    return config->degree;
+}
+
+/* Every access trains the entry of its PC. The stride is only replaced once the confidence in it has
+   run out, so one irregular access in a steady walk does not lose it. */
+static int predictStride(struct Prefetcher* prefetcher, int pc, uint32_t address, uint32_t* lines) {
+    const struct PrefetcherConfig* config = &prefetcher->config;
+    struct PrefetchEntry* entry = &prefetcher->entries[pc & (config->tableEntries - 1)];
+    uint32_t lineMask = ~(uint32_t)(prefetcher->lineWords - 1);
+    int count = 0;
+
+    if (!entry->valid || entry->pc != pc) {
+        *entry = (struct PrefetchEntry){ .valid = true, .pc = pc, .last = address };
+        return 0;
+    }
+    int stride = (int)(address - entry->last);
+    if (stride == entry->stride) {
+        if (entry->confidence < MAX_CONFIDENCE) entry->confidence++;
+    } else if (entry->confidence > 0) {
+        entry->confidence--;
+    } else {
+        entry->stride = stride;
+    }
+    entry->last = address;
+    if (entry->confidence < PREDICT_CONFIDENCE || entry->stride == 0) return 0;
+
+    uint32_t previous = address & lineMask;
+    for (int i = 0; i < config->degree; i++) {
+        uint32_t line = (address + (uint32_t)(entry->stride * (config->distance + i))) & lineMask;
+        if (line != previous) lines[count++] = line;
+        previous = line;
+    }
+    return count;
+}
+
+/* Misses are matched to the stream whose last line they follow within STREAM_WINDOW lines; two steps
+   the same way confirm its direction. A miss matching none starts a stream in place of the least
+   recently used one. */
+static int predictStream(struct Prefetcher* prefetcher, uint32_t address, bool triggered, uint32_t* lines) {
+    const struct PrefetcherConfig* config = &prefetcher->config;
+    uint32_t line = address / prefetcher->lineWords;
+    struct PrefetchEntry* stream = NULL;
+    int victim = 0;
+
+    if (!triggered) return 0;
+    for (int i = 0; i < config->tableEntries && stream == NULL; i++) {
+        struct PrefetchEntry* entry = &prefetcher->entries[i];
+        int step = (int)(line - entry->last);
+        if (entry->valid && step != 0 && step >= -STREAM_WINDOW && step <= STREAM_WINDOW) stream = entry;
+        else if (!entry->valid || (prefetcher->entries[victim].valid && entry->lastUse < prefetcher->entries[victim].lastUse))
+            victim = i;
+    }
+    if (stream == NULL) {
+        prefetcher->entries[victim] = (struct PrefetchEntry){ .valid = true, .last = line, .lastUse = ++prefetcher->useClock };
+        return 0;
+    }
+    int direction = (int)(line - stream->last) > 0 ? 1 : -1;
+    if (direction == stream->stride) {
+        if (stream->confidence < MAX_CONFIDENCE) stream->confidence++;
+    } else {
+        stream->stride = direction;
+        stream->confidence = 1;
+    }
+    stream->last = line;
+    stream->lastUse = ++prefetcher->useClock;
+    if (stream->confidence < PREDICT_CONFIDENCE) return 0;
+
+    for (int i = 0; i < config->degree; i++)
+        lines[i] = (line + (uint32_t)(direction * (config->distance + i))) * prefetcher->lineWords;
+    return config->degree;
+}
+
+int predictPrefetches(struct Prefetcher* prefetcher, int pc, uint32_t address, bool triggered, uint32_t* lines) {
+    switch (prefetcher->config.kind) {
+        case PREFETCH_NEXT_LINE: return predictNextLine(prefetcher, address, triggered, lines);
+        case PREFETCH_STRIDE:    return predictStride(prefetcher, pc, address, lines);
+        case PREFETCH_STREAM:    return predictStream(prefetcher, address, triggered, lines);
+        default:                 return 0;
+    }
+}
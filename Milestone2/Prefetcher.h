@@ -0,0 +1,63 @@
+#pragma once
+#include "Counters.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_PREFETCH_DEGREE 16
+#define MAX_PREFETCH_DISTANCE 64
+#define MAX_PREFETCH_TABLE 1024
+
+enum PrefetcherKind {
+    PREFETCH_NONE,
+    PREFETCH_NEXT_LINE, // The lines after one that missed or was a prefetch's first use
+    PREFETCH_STRIDE,    // Reference prediction table: the stride each load/store PC keeps repeating
+    PREFETCH_STREAM,    // Runs of misses to consecutive lines, followed up or down
+};
+
+struct PrefetcherConfig {
+    enum PrefetcherKind kind;
+    int degree;       // Lines requested per prediction
+    int distance;     // How far ahead the first one is: in lines, or in strides for the stride prefetcher
+    int tableEntries; // PCs tracked by the stride prefetcher, streams by the stream prefetcher; a power of two
+};
+
+/* A PC's last address and stride for the stride prefetcher, a stream's last line and direction for the
+   stream prefetcher */
+struct PrefetchEntry {
+    bool valid;
+    int pc;
+    uint32_t last;
+    int stride;     // In words, or +1/-1 lines, 0 until a direction is seen
+    int confidence; // Saturating, predictions start at 2
+    long long lastUse;
+};
+
+/* Predicts the lines the D-cache should fetch before they are asked for. It only chooses addresses;
+   the cache fills them and counts how they are used. */
+struct Prefetcher {
+    struct PrefetcherConfig config;
+    int lineWords;
+    struct PrefetchEntry* entries; // NULL for none and next-line
+    long long useClock;
+    struct PrefetchCounters* counters;
+};
+
+/* Defaults: none; degree 2, distance 1 and 16 table entries once a kind is chosen */
+void initPrefetcherConfig(struct PrefetcherConfig* config);
+
+/* Takes the kind, next-line, stride or stream, optionally followed by comma-separated key=value
+   settings, e.g. "stride,degree=4,table=64". Keys: degree, distance and table. Returns false, having
+   printed why, on an unknown kind or key or a value out of range. */
+bool parsePrefetcherConfig(struct PrefetcherConfig* config, const char* settings);
+
+void configurePrefetcher(struct Prefetcher* prefetcher, const struct PrefetcherConfig* config, int lineWords,
+                         struct PrefetchCounters* counters);
+void resetPrefetcher(struct Prefetcher* prefetcher); // Forgets every stride and stream
+void freePrefetcher(struct Prefetcher* prefetcher);
+
+/* Trains on a demand access to address by the instruction at pc. triggered is true when the access
+   missed or was the first use of a prefetched line. Fills lines with the addresses of the lines to
+   prefetch, up to MAX_PREFETCH_DEGREE, and returns how many. */
+int predictPrefetches(struct Prefetcher* prefetcher, int pc, uint32_t address, bool triggered, uint32_t* lines);
+
+const char* prefetcherKindName(enum PrefetcherKind kind);
@@ -0,0 +1,169 @@
+#pragma once
+#include "BranchPredictor.h"
+#include <stdbool.h>
+
+#define WORD_SIZE 32
+#define REGISTER_COUNT 32
+#define DEFAULT_INSTRUCTION_WORDS 1024 // Instruction region, addresses [0, dataOffset)
+#define DEFAULT_DATA_WORDS 1024        // Data region, addresses [dataOffset, memory size)
+#define MIN_PIPELINE_DEPTH 5  // IF, ID, EX, MEM, WB; deeper pipelines split EX and MEM
+#define MAX_PIPELINE_DEPTH 12
+#define MAX_ISSUE_WIDTH 4 // Instructions fetched, issued and retired per cycle
+#define MAX_STORE_BUFFER 64
+
+struct DecodedInstructionFields {
+
+    int opcode;
+    int r1;
+    int r2;
+    int r3;
+    int shamt;
+    int immediate;
+    int address;
+    int r1val; 
+    int r2val;
+    int r3val;
+};
+
+/* How IF and MEM reach the unified memory. Through one shared port IF only gets every other cycle and
+   ID and the first EX stage take two cycles each, capping throughput at 0.5 IPC. With separate
+   instruction and data ports every stage runs each cycle and the pipeline can reach IPC 1. */
+enum MemoryPorts { MEMORY_SHARED_PORT, MEMORY_SPLIT_PORTS };
+
+/* Stage whose outcome for BNE and J redirects fetch when it disagrees with the prediction */
+enum ResolveStage { RESOLVE_IN_DECODE, RESOLVE_IN_EXECUTE, RESOLVE_IN_MEMORY };
+
+/* One in-flight instruction and everything it carries from stage to stage */
+struct PipelineLatch {
+    int instruction;
+    int pc;              // Address the instruction was fetched from
+    struct BranchPrediction prediction; // Next PC IF chose, checked when the instruction resolves
+    struct DecodedInstructionFields fields; // Operand values in r1val..r3val once ID has read them
+    int destination; // Register written in WB, 0 for none
+    int result;      // ALU result or branch target; for LW the address, then the loaded value
+    bool taken;      // BNE/J outcome from EX
+    int readyCycle;  // From when result can be forwarded or written back, set by the unit producing it
+};
+
+/* The instructions a stage holds, up to the issue width, oldest in slots[0]. They move on together. */
+struct PipelineGroup {
+    struct PipelineLatch slots[MAX_ISSUE_WIDTH];
+    int size;            // 0 when the stage is empty
+    int cyclesRemaining; // Until the stage has done its work; the group can move on at 0
+    int issueCount;      // In ID, how many of the slots the pairing rules let go to EX together
+    int issueLimit;      // In ID, the IssueLimit that stopped the rest
+    bool unitBusy;       // Its operands taken, the group waits out an unpipelined unit's latency
+};
+
+/* A SW past the last MEM stage whose write has not reached memory yet */
+struct BufferedStore {
+    int address;
+    int value;
+    int pc;
+    int doneCycle; // When its D-cache write completes, once started
+};
+
+/* Stores leave the last MEM stage into the buffer and drain to the D-cache in the background, a write
+   starting every cycle so misses overlap in the MSHRs, and reach memory in order as their writes
+   complete. Loads and IF read through it, the youngest store to a word winning. */
+struct StoreBuffer {
+    struct BufferedStore entries[MAX_STORE_BUFFER];
+    int head, count;
+    int started; // Stores from the head whose writes have started
+};
+
+/* stages[0] holds the words IF has fetched, stages[1] the group in ID, then the EX stages, the MEM
+   stages and WB in stages[depth - 1]. Each stage works on its own group and pulls the next one from
+   the stage before once its own has moved on, so a group waiting on a hazard holds everything behind
+   it. ID only hands EX the slots that can issue together and keeps the rest for the next cycle. */
+struct Pipeline {
+    struct PipelineGroup stages[MAX_PIPELINE_DEPTH];
+    bool fetchReady;
+    struct StoreBuffer storeBuffer;
+};
+
+#define MAX_REORDER_BUFFER 256
+#define MAX_RESERVATION_STATIONS 64 // Per functional unit type
+#define MAX_LOAD_STORE_QUEUE 64
+#define MAX_FUNCTIONAL_UNITS 8      // Per functional unit type
+#define FETCH_QUEUE_SIZE (4 * MAX_ISSUE_WIDTH)
+
+/* Opcode classes by the unit that executes them. MULI goes to the multiplier, LW and SW to the
+   load/store unit, everything else, BNE included, to the ALUs. */
+enum FunctionalUnit { UNIT_ALU, UNIT_MULTIPLIER, UNIT_LOAD_STORE, UNIT_COUNT };
+
+/* Latency and throughput of a unit type. A pipelined unit starts an instruction every cycle; an
+   unpipelined one is busy for the whole latency. */
+struct UnitTiming {
+    int latency; // Cycles from the operands going in to the result coming out
+    bool pipelined;
+};
+
+struct OutOfOrderConfig {
+    int reorderBufferSize;
+    int stations[UNIT_COUNT]; // Reservation stations per unit type; for the load/store unit the LSQ entries
+    int units[UNIT_COUNT];    // Units of each type, timed by Cpu.unitTimings
+};
+
+/* A source operand after renaming: the value itself, or the reorder buffer entry that will produce it */
+struct RenamedOperand {
+    int value;
+    int tag; // -1 once value holds the operand
+};
+
+enum ReorderBufferState { ROB_WAITING, ROB_EXECUTING, ROB_DONE };
+
+struct ReorderBufferEntry {
+    long long sequence; // Program order, also orders the reservation stations and the LSQ
+    int instruction;
+    int pc;
+    struct DecodedInstructionFields fields;
+    struct BranchPrediction prediction;
+    int unit;           // FunctionalUnit
+    int destination;    // Register written at commit, 0 for none
+    int state;          // ReorderBufferState
+    int completeCycle;  // When an executing instruction puts its result on the common data bus
+    int result;         // Register value, or the BNE/J target
+    bool taken;         // BNE/J outcome
+    bool mispredicted;  // Fetch went down the wrong path after it, counted and trained at commit
+};
+
+struct ReservationStation {
+    bool busy;
+    int robIndex;
+    struct RenamedOperand operands[2]; // R2 or the base, then R3 (ADD, SUB) or R1 (BNE)
+};
+
+struct FetchedInstruction {
+    int instruction;
+    int pc;
+    struct BranchPrediction prediction;
+    int readyCycle; // When the I-cache has delivered it and dispatch can take it
+};
+
+/* LW and SW in program order, from dispatch to commit. The entries double as the load/store unit's
+   reservation stations; a store writes memory only when it commits. */
+struct LoadStoreEntry {
+    int robIndex;
+    bool isStore;
+    struct RenamedOperand base, data; // data is the value a SW stores
+    bool issued;
+    int address; // Once issued
+};
+
+/* Tomasulo-style backend: IF fills the fetch queue, dispatch renames into the reorder buffer and the
+   reservation stations or the LSQ, instructions issue to the units once their operands arrive on the
+   common data bus and commit in order from the reorder buffer head */
+struct OutOfOrderCore {
+    struct FetchedInstruction fetchQueue[FETCH_QUEUE_SIZE];
+    int fetchHead, fetchCount;
+    int fetchResumeCycle; // IF waits for a line the I-cache is filling until then
+    struct ReorderBufferEntry reorderBuffer[MAX_REORDER_BUFFER];
+    int robHead, robCount;
+    struct ReservationStation stations[UNIT_LOAD_STORE][MAX_RESERVATION_STATIONS]; // ALU and multiplier
+    struct LoadStoreEntry loadStoreQueue[MAX_LOAD_STORE_QUEUE];
+    int lsqHead, lsqCount;
+    int renameTable[REGISTER_COUNT]; // Reorder buffer entry writing each register, -1 for the register file
+    int unitFreeCycle[UNIT_COUNT][MAX_FUNCTIONAL_UNITS]; // When each unit can start its next instruction
+    long long nextSequence;
+};
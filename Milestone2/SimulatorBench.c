@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200809L
+#include "Cpu.h"
+#include "Pipeline.h"
+#include "Trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Host-side throughput benchmark for the pipeline engine. Each workload is generated as assembly,
+   loaded once, then simulated from the same initial state a number of times; the report gives host
+   nanoseconds per simulated cycle and per retired instruction with their spread across the runs. */
+
+struct Workload {
+    const char* name;
+    const char* description;
+    void (*write)(FILE* file, int scale, int dataOffset);
+    int (*instructionCount)(int scale);
+    long long (*dataWords)(int scale);
+};
+
+static double nowNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/* Immediates are 18 bits, larger constants are built in two steps */
+static void writeLoadConstant(FILE* file, int reg, int value) {
+    if (value <= 0x1FFFF) {
+        fprintf(file, "ADDI R%d R0 %d\n", reg, value);
+    } else {
+        fprintf(file, "ADDI R%d R0 %d\nSLL R%d R%d 10\nORI R%d R%d %d\n", reg, value >> 10, reg, reg, reg, reg, value & 1023);
+    }
+}
+
+/* Straight-line chain where every instruction reads the result of the one before it */
+static void writeAluChain(FILE* file, int scale, int dataOffset) {
+    static const char* pattern[] = {
+        "ADDI R1 R1 3", "ADD R2 R1 R2", "SUB R3 R2 R1", "MULI R4 R3 3",
+        "ANDI R5 R4 4095", "ORI R6 R5 1", "SLL R7 R6 1", "SRL R1 R7 1"
+    };
+    (void)dataOffset;
+    for (int i = 0; i < scale * 8; i++)
+        fprintf(file, "%s\n", pattern[i % 8]);
+}
+
+static int aluChainInstructions(int scale) { return scale * 8; }
+
+/* Every load is consumed by the very next instruction */
+static void writeLoadUseLoop(FILE* file, int scale, int dataOffset) {
+    writeLoadConstant(file, 10, dataOffset);
+    writeLoadConstant(file, 14, scale);
+    fprintf(file, "loop: LW R5 R10 0\nADD R6 R5 R13\nSW R6 R10 0\nLW R7 R10 0\nADDI R8 R7 1\n"
+                  "ADDI R13 R13 1\nBNE R13 R14 loop\n");
+}
+
+/* Four BNEs per iteration: two taken forward, one not taken and the loop branch */
+static void writeBranchLoop(FILE* file, int scale, int dataOffset) {
+    (void)dataOffset;
+    writeLoadConstant(file, 14, scale);
+    fprintf(file, "ADDI R1 R0 1\n"
+                  "loop: BNE R1 R0 first\nADDI R2 R2 1\n"
+                  "first: ADDI R13 R13 1\nBNE R13 R0 second\nADDI R2 R2 1\n"
+                  "second: BNE R0 R0 third\n"
+                  "third: ADDI R3 R3 1\nBNE R13 R14 loop\n");
+}
+
+/* Writes eight consecutive words, reads them back and moves on, walking the whole data region */
+static void writeStreamLoop(FILE* file, int scale, int dataOffset) {
+    writeLoadConstant(file, 10, dataOffset);
+    writeLoadConstant(file, 14, scale);
+    fprintf(file, "loop: ");
+    for (int i = 0; i < 8; i++) fprintf(file, "SW R13 R10 %d\n", i);
+    for (int i = 0; i < 8; i++) fprintf(file, "LW R%d R10 %d\n", i + 1, i);
+    fprintf(file, "ADDI R10 R10 8\nADDI R13 R13 1\nBNE R13 R14 loop\n");
+}
+
+static int loopInstructions(int scale) { (void)scale; return 64; }
+static long long noDataWords(int scale) { (void)scale; return DEFAULT_DATA_WORDS; }
+static long long streamDataWords(int scale) { return (scale * 8LL + 1023) / 1024 * 1024; }
+
+static const struct Workload workloads[] = {
+    { "alu-chain", "dependent ALU chain, 8 x scale instructions", writeAluChain, aluChainInstructions, noDataWords },
+    { "load-use", "loop of loads feeding the next instruction", writeLoadUseLoop, loopInstructions, noDataWords },
+    { "branch", "loop of taken and not-taken BNEs", writeBranchLoop, loopInstructions, noDataWords },
+    { "stream", "store/load stream through the data region", writeStreamLoop, loopInstructions, streamDataWords },
+};
+#define WORKLOAD_COUNT (int)(sizeof(workloads) / sizeof(workloads[0]))
+
+static int compareDoubles(const void* a, const void* b) {
+    double left = *(const double*)a, right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+struct Summary {
+    double minimum, median, mean, deviation;
+};
+
+static struct Summary summarize(double* samples, int count) {
+    struct Summary summary = { 0, 0, 0, 0 };
+
+    qsort(samples, count, sizeof(double), compareDoubles);
+    for (int i = 0; i < count; i++) summary.mean += samples[i];
+    summary.mean /= count;
+    for (int i = 0; i < count; i++) summary.deviation += (samples[i] - summary.mean) * (samples[i] - summary.mean);
+    summary.deviation = count > 1 ? sqrt(summary.deviation / (count - 1)) : 0;
+    summary.minimum = samples[0];
+    summary.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    return summary;
+}
+
+/* runPipelineToCompletion with a cycle budget, so a program that never drains still gets measured */
+static bool runPipelineFor(struct Cpu* cpu, long long maxCycles) {
+    do {
+        runPipeline(cpu);
+        cpu->cycle++;
+    } while (!pipelineDone(cpu) && cpu->counters.cycles < maxCycles);
+    return pipelineDone(cpu);
+}
+
+static bool runWorkload(const struct Workload* workload, int scale, int repeats, long long maxCycles, int depth,
+                        enum MemoryPorts ports, int width) {
+    char path[] = "/tmp/casim_bench_XXXXXX";
+    int instructionWords = (workload->instructionCount(scale) + 1023) / 1024 * 1024;
+    struct Cpu cpu;
+    struct MemoryImage loadedMemory;
+
+    int descriptor = mkstemp(path);
+    if (descriptor < 0) {
+        printf("Cannot create a temporary program file\n");
+        return false;
+    }
+    FILE* file = fdopen(descriptor, "w");
+    workload->write(file, scale, instructionWords);
+    fclose(file);
+
+    initCpu(&cpu, instructionWords, workload->dataWords(scale));
+    cpu.pipelineDepth = depth;
+    cpu.memoryPorts = ports;
+    cpu.issueWidth = width;
+    bool loaded = loadProgram(&cpu, path);
+    unlink(path);
+    if (!loaded) {
+        printf("%s: generated program does not assemble\n", workload->name);
+        freeCpu(&cpu);
+        return false;
+    }
+    captureMemory(&cpu.memory, &loadedMemory);
+
+    double* perCycle = malloc(repeats * sizeof(double));
+    double* perInstruction = malloc(repeats * sizeof(double));
+    bool drained = true;
+    struct PerfCounters counters = { 0 };
+
+    // The first run only warms caches and the page allocator
+    for (int r = -1; r < repeats; r++) {
+        restoreMemory(&cpu.memory, &loadedMemory);
+        buildPredecodeTable(&cpu.predecode, &cpu.memory, cpu.lineCount);
+        resetProcessor(&cpu);
+
+        double start = nowNanoseconds();
+        drained = runPipelineFor(&cpu, maxCycles);
+        double elapsed = nowNanoseconds() - start;
+
+        counters = cpu.counters;
+        if (r < 0) continue;
+        perCycle[r] = elapsed / counters.cycles;
+        perInstruction[r] = elapsed / (counters.instructionsRetired > 0 ? counters.instructionsRetired : 1);
+    }
+
+    struct Summary cycleSummary = summarize(perCycle, repeats);
+    struct Summary instructionSummary = summarize(perInstruction, repeats);
+    printf("%-10s %12lld %12lld %7.3f %9.2f %9.2f %9.2f %8.2f %9.2f %9.2f%s\n", workload->name, counters.cycles,
+           counters.instructionsRetired, counters.instructionsRetired > 0 ? (double)counters.cycles / counters.instructionsRetired : 0.0,
+           cycleSummary.minimum, cycleSummary.median, cycleSummary.mean, cycleSummary.deviation,
+           instructionSummary.minimum, instructionSummary.median, drained ? "" : "  (cycle limit)");
+
+    free(perCycle);
+    free(perInstruction);
+    freeMemoryImage(&loadedMemory);
+    freeCpu(&cpu);
+    return true;
+}
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [--workload name] [--scale N] [--repeats N] [--max-cycles N] [--depth N] [--ports shared|split] [--width N]\n", program);
+    printf("Workloads:\n");
+    for (int w = 0; w < WORKLOAD_COUNT; w++)
+        printf("  %-10s %s\n", workloads[w].name, workloads[w].description);
+}
+
+int main(int argc, char** argv) {
+    const char* only = NULL;
+    int scale = 10000;
+    int repeats = 10;
+    long long maxCycles = 10000000;
+    int depth = MIN_PIPELINE_DEPTH;
+    int ports = MEMORY_SHARED_PORT;
+    int width = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-cycles") == 0 && i + 1 < argc) {
+            maxCycles = strtoll(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ports") == 0 && i + 1 < argc) {
+            ports = parseMemoryPorts(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (scale < 1 || repeats < 1 || maxCycles < 1 || depth < MIN_PIPELINE_DEPTH || depth > MAX_PIPELINE_DEPTH || ports < 0 ||
+        width < 1 || width > MAX_ISSUE_WIDTH) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    traceLevel = TRACE_LEVEL_NONE;
+    printf("%d-stage pipeline, %s memory ports, %d-wide issue, scale %d, %d timed runs per workload after one warm-up\n", depth,
+           memoryPortsName(ports), width, scale, repeats);
+    printf("%-10s %12s %12s %7s %9s %9s %9s %8s %9s %9s\n", "workload", "cycles", "instructions", "CPI",
+           "min", "median", "mean", "stddev", "min", "median");
+    printf("%-10s %12s %12s %7s %36s %19s\n", "", "", "", "", "------------ ns/cycle ------------", "--- ns/inst ---");
+
+    int failed = 0, matched = 0;
+    for (int w = 0; w < WORKLOAD_COUNT; w++) {
+        if (only != NULL && strcmp(only, workloads[w].name) != 0) continue;
+        matched++;
+        if (!runWorkload(&workloads[w], scale, repeats, maxCycles, depth, ports, width)) failed++;
+    }
+    if (matched == 0) {
+        printf("Unknown workload: %s\n", only);
+        printUsage(argv[0]);
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
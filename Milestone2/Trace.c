@@ -0,0 +1,12 @@
+#include "Trace.h"
+#include <string.h>
+
+int traceLevel = CASIM_TRACE_LEVEL;
+
+int parseTraceLevel(const char* name) {
+    if (strcmp(name, "none") == 0) return TRACE_LEVEL_NONE;
+    if (strcmp(name, "summary") == 0) return TRACE_LEVEL_SUMMARY;
+    if (strcmp(name, "instruction") == 0) return TRACE_LEVEL_INSTRUCTION;
+    if (strcmp(name, "cycle") == 0) return TRACE_LEVEL_CYCLE;
+    return -1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdio.h>
+
+#define TRACE_LEVEL_NONE        0 // Silent: no trace and no end-of-run report
+#define TRACE_LEVEL_SUMMARY     1 // End-of-run report: cycle count, final registers and memory
+#define TRACE_LEVEL_INSTRUCTION 2 // Plus one line per executed instruction, store, register write and flush
+#define TRACE_LEVEL_CYCLE       3 // Plus the full pipeline and register view every cycle
+
+/* Highest level compiled in, set by the CASIM_TRACE_LEVEL CMake option. Calls above it compile away. */
+#ifndef CASIM_TRACE_LEVEL
+#define CASIM_TRACE_LEVEL TRACE_LEVEL_CYCLE
+#endif
+
+extern int traceLevel; // Runtime level, can only lower the compiled-in one
+
+#define TRACE_AT(level) (CASIM_TRACE_LEVEL >= (level) && traceLevel >= (level))
+
+#if CASIM_TRACE_LEVEL >= TRACE_LEVEL_SUMMARY
+#define TRACE_SUMMARY(...) do { if (traceLevel >= TRACE_LEVEL_SUMMARY) printf(__VA_ARGS__); } while (0)
+#else
+#define TRACE_SUMMARY(...) ((void)0)
+#endif
+
+#if CASIM_TRACE_LEVEL >= TRACE_LEVEL_INSTRUCTION
+#define TRACE_INSTRUCTION(...) do { if (traceLevel >= TRACE_LEVEL_INSTRUCTION) printf(__VA_ARGS__); } while (0)
+#else
+#define TRACE_INSTRUCTION(...) ((void)0)
+#endif
+
+int parseTraceLevel(const char* name); // Returns -1 for an unknown level name
@@ -1,710 +1,330 @@
-#include "FileReader.h"
+#include "Cpu.h"
+#include "Pipeline.h"
+#include "OutOfOrder.h"
+#include "LatencyTable.h"
+#include "Cache.h"
+#include "Functional.h"
+#include "Bench.h"
+#include "Batch.h"
+#include "Checkpoint.h"
+#include "Trace.h"
+#include "BinaryTrace.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
-#define MAIN_MEMORY_SIZE 2048
-#define WORD_SIZE 32
-#define REGISTER_COUNT 32
-#define MAX_LINES 64
-#define MAX_INSTRUCTION_TOKENS 256
-#define DATA_OFFSET 1024
-
-struct DecodedInstructionFields {
-
-    int opcode;
-    int r1;
-    int r2;
-    int r3;
-    int shamt;
-    int immediate;
-    int address;
-    int r1val; 
-    int r2val;
-    int r3val;
-};
-
-struct Pipeline {
-    struct DecodedInstructionFields decodedInstructionFields;
-    int fetchPhaseInst;
-    int decodePhaseInst;
-    int executePhaseInst;
-    int memoryPhaseInst;
-    int writebackPhaseInst;
-    int decodeCyclesRemaining;
-    int executeCyclesRemaining;
-};
-
-
-void parseTextInstruction(); // Parses the text instructions into their binary representation.
-void readFileToMemory(char* filepath);
-void initRegisters();
-void initMemory();
-void initPipeline();
-void runPipeline();
-void printMainMemoryMinimal();
-
-char lines[MAX_LINES][MAX_INSTRUCTION_TOKENS]; //An array to hold the text instructions after reading from file
-int lineCount = 0;
-
-int mainMemory[MAIN_MEMORY_SIZE];
-int registers[REGISTER_COUNT];
-int programCounter = 0;
-struct Pipeline pipeline;
-int temporaryExecuteResult = 0;
-int temporaryExecuteDestination = 0;
-int temporaryStoreSource = 0;
-
-bool isFlushing = 0;
-bool temporaryShouldBranch = 0;
-bool isForwarding = 0;
-int forwardingDestination = 0;
-
-char* filepath = "../programInstructions.txt";
-int cycle = 1;
-bool fetchReady = true;
-
-
-
-void initRegisters(){
-    for(int i = 0; i < REGISTER_COUNT; i++)
-        registers[i] = 0;
-}
-
-void initMemory(){
-    for(int i = 0; i < MAIN_MEMORY_SIZE; i++)
-        mainMemory[i] = 0;
-}
-
-void initPipeline() {
-    pipeline.fetchPhaseInst = 0;
-
-    pipeline.decodePhaseInst = 0;
-    pipeline.decodedInstructionFields.opcode = 0;
-    pipeline.decodedInstructionFields.r1 = 0;
-    pipeline.decodedInstructionFields.r2 = 0;
-    pipeline.decodedInstructionFields.r3 = 0;
-    pipeline.decodedInstructionFields.shamt = 0;
-    pipeline.decodedInstructionFields.immediate = 0;
-    pipeline.decodedInstructionFields.address = 0;
-
-    pipeline.executePhaseInst = 0;
-    pipeline.memoryPhaseInst = 0;
-    pipeline.writebackPhaseInst = 0;
-
-    pipeline.decodeCyclesRemaining = 0;
-    pipeline.executeCyclesRemaining = 0;
-
-}
-
-
-
-void fetch();
-void decode();
-void execute();
-void memory();
-void writeback();
-void runPipeline();
-
-void printMainMemory();
-void printPipeline();
-void printRegisters();
-void printRegistersMinimal();
-
-bool pipelineDone() {
-    return pipeline.fetchPhaseInst == 0 &&
-        pipeline.decodePhaseInst == 0 &&
-        pipeline.executePhaseInst == 0 &&
-        pipeline.memoryPhaseInst == 0 &&
-        pipeline.writebackPhaseInst == 0;
-}
-
-int main() {
-    readFileToMemory(filepath);
-    parseTextInstruction();
-
-
-    runPipeline();
-    cycle++;
-    while (!pipelineDone()) {
-        runPipeline();
-        cycle++;    }
-
-    printRegisters();
-    printMainMemoryMinimal();
-}
-
-void runPipeline() {
-    writeback();
-    memory();
-    execute();
-    decode();
-    fetch();
-
-    if ( (pipeline.fetchPhaseInst != 0 || pipeline.decodePhaseInst != 0 || pipeline.executePhaseInst != 0
-    || pipeline.memoryPhaseInst != 0 || pipeline.writebackPhaseInst != 0)){
-    printf("\033[1;31m--- Cycle %d ---\033[0m\n", cycle);
-    printPipeline();
-    printRegistersMinimal();
+int main(int argc, char** argv) {
+    bool functionalMode = false;
+    bool outOfOrderMode = false;
+    struct OutOfOrderConfig outOfOrderConfig;
+    struct UnitTiming unitTimings[UNIT_COUNT];
+    struct MemoryHierarchyConfig memoryHierarchy;
+    bool benchDispatch = false;
+    bool benchScaling = false;
+    int instructionWords = DEFAULT_INSTRUCTION_WORDS;
+    long long dataWords = DEFAULT_DATA_WORDS;
+    char* filepath = "../programInstructions.txt";
+    char* traceFilepath = NULL;
+    char* statsFilepath = NULL;
+    char* latenciesPath = NULL;
+    char* saveCheckpointPath = NULL;
+    char* restoreCheckpointPath = NULL;
+    long long checkpointCycle = 0;
+    long long checkpointInstructions = 0;
+    enum PredictorKind predictor = DEFAULT_PREDICTOR;
+    enum ResolveStage resolveStage = RESOLVE_IN_EXECUTE;
+    bool forwarding = true;
+    int pipelineDepth = MIN_PIPELINE_DEPTH;
+    enum MemoryPorts memoryPorts = MEMORY_SHARED_PORT;
+    int issueWidth = 1;
+    int storeBufferEntries = 0;
+    bool batchMode = false;
+    char* batchListPath = NULL;
+    int jobs = 0;
+    char** programs = malloc(argc * sizeof(char*));
+    int programCount = 0;
+#if defined(__GNUC__)
+    enum DispatchStyle dispatch = DISPATCH_THREADED;
+#else
+    enum DispatchStyle dispatch = DISPATCH_SWITCH;
+#endif
+
+    initOutOfOrderConfig(&outOfOrderConfig);
+    initMemoryHierarchyConfig(&memoryHierarchy);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--functional") == 0) {
+            functionalMode = true;
+            outOfOrderMode = false;
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            functionalMode = false;
+            outOfOrderMode = false;
+        } else if (strcmp(argv[i], "--out-of-order") == 0) {
+            functionalMode = false;
+            outOfOrderMode = true;
+        } else if (strcmp(argv[i], "--ooo-config") == 0 && i + 1 < argc) {
+            if (!parseOutOfOrderConfig(&outOfOrderConfig, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--latencies") == 0 && i + 1 < argc) {
+            latenciesPath = argv[++i];
+        } else if (strcmp(argv[i], "--icache") == 0 && i + 1 < argc) {
+            if (!parseCacheConfig(&memoryHierarchy.instructionCache, "I-cache", argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--dcache") == 0 && i + 1 < argc) {
+            if (!parseCacheConfig(&memoryHierarchy.dataCache, "D-cache", argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--l2cache") == 0 && i + 1 < argc) {
+            if (!parseCacheConfig(&memoryHierarchy.l2Cache, "L2 cache", argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--dram") == 0 && i + 1 < argc) {
+            if (!parseDramConfig(&memoryHierarchy.dram, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) {
+            if (!parsePrefetcherConfig(&memoryHierarchy.prefetcher, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--dispatch") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "switch") == 0) dispatch = DISPATCH_SWITCH;
+            else if (strcmp(argv[i], "handlers") == 0) dispatch = DISPATCH_HANDLERS;
+            else if (strcmp(argv[i], "threaded") == 0) dispatch = DISPATCH_THREADED;
+            else {
+                printf("Unknown dispatch style: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--predictor") == 0 && i + 1 < argc) {
+            i++;
+            if (parsePredictorKind(argv[i]) < 0) {
+                printf("Unknown branch predictor: %s\n", argv[i]);
+                return 1;
+            }
+            predictor = parsePredictorKind(argv[i]);
+        } else if (strcmp(argv[i], "--resolve-stage") == 0 && i + 1 < argc) {
+            i++;
+            if (parseResolveStage(argv[i]) < 0) {
+                printf("Unknown branch resolution stage: %s\n", argv[i]);
+                return 1;
+            }
+            resolveStage = parseResolveStage(argv[i]);
+        } else if (strcmp(argv[i], "--no-forwarding") == 0) {
+            forwarding = false;
+        } else if (strcmp(argv[i], "--ports") == 0 && i + 1 < argc) {
+            i++;
+            if (parseMemoryPorts(argv[i]) < 0) {
+                printf("Unknown memory port configuration: %s\n", argv[i]);
+                return 1;
+            }
+            memoryPorts = parseMemoryPorts(argv[i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            pipelineDepth = atoi(argv[++i]);
+            if (pipelineDepth < MIN_PIPELINE_DEPTH || pipelineDepth > MAX_PIPELINE_DEPTH) {
+                printf("Pipeline depth must be %d to %d stages: %s\n", MIN_PIPELINE_DEPTH, MAX_PIPELINE_DEPTH, argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            issueWidth = atoi(argv[++i]);
+            if (issueWidth < 1 || issueWidth > MAX_ISSUE_WIDTH) {
+                printf("Issue width must be 1 to %d: %s\n", MAX_ISSUE_WIDTH, argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--store-buffer") == 0 && i + 1 < argc) {
+            storeBufferEntries = atoi(argv[++i]);
+            if (storeBufferEntries < 0 || storeBufferEntries > MAX_STORE_BUFFER) {
+                printf("Store buffer must hold 0 to %d stores: %s\n", MAX_STORE_BUFFER, argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            i++;
+            traceLevel = parseTraceLevel(argv[i]);
+            if (traceLevel < 0) {
+                printf("Unknown trace level: %s\n", argv[i]);
+                return 1;
+            }
+            if (traceLevel > CASIM_TRACE_LEVEL) {
+                printf("Trace level '%s' is above the compiled-in level, rebuild with -DCASIM_TRACE_LEVEL=%s\n", argv[i], argv[i]);
+                traceLevel = CASIM_TRACE_LEVEL;
+            }
+        } else if (strcmp(argv[i], "--trace-file") == 0 && i + 1 < argc) {
+            traceFilepath = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsFilepath = argv[++i];
+        } else if (strcmp(argv[i], "--instruction-words") == 0 && i + 1 < argc) {
+            instructionWords = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--data-words") == 0 && i + 1 < argc) {
+            dataWords = strtoll(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--save-checkpoint") == 0 && i + 1 < argc) {
+            saveCheckpointPath = argv[++i];
+        } else if (strcmp(argv[i], "--restore-checkpoint") == 0 && i + 1 < argc) {
+            restoreCheckpointPath = argv[++i];
+        } else if ((strcmp(argv[i], "--checkpoint-cycle") == 0 || strcmp(argv[i], "--checkpoint-instructions") == 0) && i + 1 < argc) {
+            bool cycle = strcmp(argv[i], "--checkpoint-cycle") == 0;
+            long long count = atoll(argv[++i]);
+            if (count <= 0) {
+                printf("Checkpoint %s must be positive: %s\n", cycle ? "cycle" : "instruction count", argv[i]);
+                return 1;
+            }
+            if (cycle) checkpointCycle = count;
+            else checkpointInstructions = count;
+        } else if (strcmp(argv[i], "--bench-dispatch") == 0) {
+            benchDispatch = true;
+        } else if (strcmp(argv[i], "--bench-scaling") == 0) {
+            benchScaling = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batchMode = true;
+        } else if (strcmp(argv[i], "--batch-list") == 0 && i + 1 < argc) {
+            batchMode = true;
+            batchListPath = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            printf("Usage: %s [--functional | --pipeline | --out-of-order] [--ooo-config key=value,...] [--latencies file] [--icache on|key=value,...] [--dcache on|key=value,...] [--l2cache on|key=value,...] [--dram on|key=value,...] [--prefetch next-line|stride|stream[,key=value,...]] [--dispatch switch|handlers|threaded] [--predictor not-taken|btfn|bimodal|gshare] [--resolve-stage id|ex|mem] [--no-forwarding] [--depth N] [--ports shared|split] [--width N] [--store-buffer N] [--trace none|summary|instruction|cycle] [--trace-file path] [--stats file.json|file.csv] [--instruction-words N] [--data-words N] [--save-checkpoint file --checkpoint-cycle N | --checkpoint-instructions N] [--restore-checkpoint file] [--bench-dispatch | --bench-scaling] [program file]\n", argv[0]);
+            printf("       %s --batch [--batch-list file] [--jobs N] [--functional | --out-of-order] [program files...]\n", argv[0]);
+            return 1;
+        } else {
+            filepath = argv[i];
+            programs[programCount++] = argv[i];
+        }
     }
-    //printMainMemoryMinimal();
-
-}
 
-void flushPipeline() {
-    pipeline.fetchPhaseInst = 0;
-    pipeline.decodePhaseInst = 0;
-    pipeline.decodeCyclesRemaining = 0;
-    isFlushing = true;
-    printf("\033[1;35m--- HAZARD DETECTED, FLUSHING PIPELINE ---\033[0m\n");
-}
-
-void checkForwarding() {
-
-
-
-    // //Compare execute dest. with decode srcs
-    // if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r2 && temporaryExecuteDestination == pipeline.decodedInstructionFields.r3) {
-    //     isForwarding = true;
-    //     forwardingDestination = pipeline.decodedInstructionFields.r2;
-    // }else if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r2) {
-    //     isForwarding = true;
-    //     forwardingDestination = pipeline.decodedInstructionFields.r2;
-    // }else if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r3) {
-    //     isForwarding = true;
-    //     forwardingDestination = pipeline.decodedInstructionFields.r3;
-    // }
-
-    if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r1 && temporaryExecuteDestination != 0) {
-        isForwarding = true;
-        forwardingDestination = pipeline.decodedInstructionFields.r1;
+    // Once the engine is known, since the out-of-order core has its own default multiplier latency
+    initUnitTimings(unitTimings, outOfOrderMode);
+    if (latenciesPath != NULL && !loadUnitTimings(unitTimings, latenciesPath)) return 1;
+    if ((memoryHierarchy.l2Cache.enabled || memoryHierarchy.dram.enabled) && !memoryHierarchy.instructionCache.enabled &&
+        !memoryHierarchy.dataCache.enabled) {
+        printf("--l2cache and --dram serve L1 misses and need --icache or --dcache\n");
+        return 1;
     }
-
-
-    if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r2 && temporaryExecuteDestination != 0) {
-        isForwarding = true;
-        forwardingDestination = pipeline.decodedInstructionFields.r2;
+    if (memoryHierarchy.prefetcher.kind != PREFETCH_NONE && !memoryHierarchy.dataCache.enabled) {
+        printf("--prefetch fills the D-cache and needs --dcache\n");
+        return 1;
     }
 
-    if (temporaryExecuteDestination == pipeline.decodedInstructionFields.r3 && temporaryExecuteDestination != 0) {
-        isForwarding = true;
-        forwardingDestination = pipeline.decodedInstructionFields.r3;
+    if (traceFilepath != NULL && (functionalMode || outOfOrderMode)) {
+        printf("--trace-file records pipeline stages and is not available with %s\n", functionalMode ? "--functional" : "--out-of-order");
+        return 1;
     }
-
-
-
-}
-
-void fetch() {
-    if (fetchReady && programCounter < lineCount && !isFlushing) {
-        pipeline.fetchPhaseInst = mainMemory[programCounter];
-        programCounter++;
-        fetchReady = false;
-    }else {
-        pipeline.fetchPhaseInst = 0;
-        fetchReady = true;
+    if (traceFilepath != NULL && batchMode) {
+        printf("--trace-file is for a single program, not --batch\n");
+        return 1;
     }
-} //TODO: handle PC reaching 1024
-
-void decode() {
-
-    if (pipeline.fetchPhaseInst == 0 && pipeline.decodePhaseInst == 0) return;
-
-    if (pipeline.decodeCyclesRemaining == 0)
-        pipeline.decodePhaseInst = pipeline.fetchPhaseInst;
-        if (pipeline.decodePhaseInst == 0) return;
-
-
-    if (pipeline.decodeCyclesRemaining == 0) {
 
-        pipeline.decodeCyclesRemaining = 1;
-    }else {
-        pipeline.decodedInstructionFields.opcode     = (pipeline.decodePhaseInst >> 28) & 0xF;
-        pipeline.decodedInstructionFields.r1         = (pipeline.decodePhaseInst >> 23) & 0x1F;
-        pipeline.decodedInstructionFields.r2         = (pipeline.decodePhaseInst >> 18) & 0x1F;
-        pipeline.decodedInstructionFields.r3         = (pipeline.decodePhaseInst >> 13) & 0x1F;
-        pipeline.decodedInstructionFields.shamt      = pipeline.decodePhaseInst & 0x1FFF;
-        pipeline.decodedInstructionFields.immediate  = pipeline.decodePhaseInst & 0x3FFFF;
-        if ((pipeline.decodedInstructionFields.immediate & 0x20000) >> 17 == 1)
-            pipeline.decodedInstructionFields.immediate |= 0xFFFC0000; // Make it negative
-        pipeline.decodedInstructionFields.address    = pipeline.decodePhaseInst & 0xFFFFFFF;
-        pipeline.decodedInstructionFields.r1val = registers[pipeline.decodedInstructionFields.r1];
-        pipeline.decodedInstructionFields.r2val = registers[pipeline.decodedInstructionFields.r2];
-        pipeline.decodedInstructionFields.r3val = registers[pipeline.decodedInstructionFields.r3];
-
-        checkForwarding();
-
-        pipeline.decodeCyclesRemaining--;
+    if (saveCheckpointPath != NULL && checkpointCycle == 0 && checkpointInstructions == 0) {
+        printf("--save-checkpoint needs --checkpoint-cycle or --checkpoint-instructions\n");
+        return 1;
     }
-
-}
-
-void execute() {
-
-    if (pipeline.executePhaseInst == 0) pipeline.executeCyclesRemaining = 0;
-
-    if (pipeline.decodePhaseInst == 0 && pipeline.executePhaseInst == 0) return;
-
-    if (pipeline.executePhaseInst == 0 && pipeline.decodeCyclesRemaining != 0) return;
-
-    if ( pipeline.executeCyclesRemaining == 0 && pipeline.decodeCyclesRemaining == 0)
-        pipeline.executePhaseInst = pipeline.decodePhaseInst;
-
-    if (pipeline.executeCyclesRemaining == 0) {
-
-        pipeline.executeCyclesRemaining = 1;
-
-    }else {
-
-        if (pipeline.decodedInstructionFields.r1 == forwardingDestination && isForwarding)
-            pipeline.decodedInstructionFields.r1val = temporaryExecuteResult;
-        if (pipeline.decodedInstructionFields.r2 == forwardingDestination && isForwarding)
-            pipeline.decodedInstructionFields.r2val = temporaryExecuteResult;
-        if (pipeline.decodedInstructionFields.r3 == forwardingDestination && isForwarding)
-            pipeline.decodedInstructionFields.r3val = temporaryExecuteResult;
-
-        switch (pipeline.decodedInstructionFields.opcode) {
-            case 0: //ADD
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val + pipeline.decodedInstructionFields.r3val;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d + %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.r3val);
-                break;
-            case 1: //SUB
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val - pipeline.decodedInstructionFields.r3val;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d - %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.r3val);
-                break;
-            case 2: //MULI
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val * pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d * %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate);
-
-                break;
-            case 3: //ADDI
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val + pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d + %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate);
-
-                break;
-            case 4: //BNE
-                temporaryExecuteResult = programCounter + 1 + pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = -1;
-
-
-                temporaryShouldBranch =
-                    pipeline.decodedInstructionFields.r1val != pipeline.decodedInstructionFields.r2val ? true : false;
-                if (temporaryShouldBranch)
-                    printf("\nBNE Executed %d = 1 + %d + %d\n", temporaryExecuteResult, programCounter, pipeline.decodedInstructionFields.immediate);
-                    flushPipeline();
-                break;
-            case 5: //ANDI
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val & pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d AND %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate);
-
-                break;
-            case 6: //ORI
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val | pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d OR %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate);
-
-                break;
-            case 7: //J
-                temporaryExecuteResult = (programCounter & 0xF0000000) | pipeline.decodedInstructionFields.address;
-                temporaryExecuteDestination = -1;
-                printf("\nExecuted PC = %d CONCAT %d\n", (programCounter & 0xF0000000), pipeline.decodedInstructionFields.address);
-                flushPipeline();
-                break;
-            case 8: //SLL
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val << pipeline.decodedInstructionFields.shamt;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d SHIFT LEFT %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.shamt);
-                break;
-            case 9: //SRL
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val >> pipeline.decodedInstructionFields.shamt;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d SHIFT RIGHT %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.shamt);
-                break;
-            case 10: //LW
-
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val + pipeline.decodedInstructionFields.immediate;
-                temporaryExecuteDestination = pipeline.decodedInstructionFields.r1;
-                printf("\nExecuted %d = %d + %d + %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate, DATA_OFFSET);
-                break;
-            case 11: //SW
-                temporaryExecuteResult = pipeline.decodedInstructionFields.r2val + pipeline.decodedInstructionFields.immediate;
-                temporaryStoreSource = pipeline.decodedInstructionFields.r1;
-                temporaryExecuteDestination = -1;
-                printf("\nExecuted %d = %d + %d + %d\n", temporaryExecuteResult, pipeline.decodedInstructionFields.r2val, pipeline.decodedInstructionFields.immediate, DATA_OFFSET);
-
-                break;
-            default:
-                break;
-        }
-
-
-        isForwarding = false;
-        pipeline.executeCyclesRemaining--;
+    if (functionalMode && checkpointCycle > 0) {
+        printf("--functional has no cycles, checkpoint it with --checkpoint-instructions\n");
+        return 1;
     }
-
-}
-
-void memory() {
-    if (pipeline.memoryPhaseInst == 0 && pipeline.executePhaseInst == 0) return;
-    if (pipeline.executeCyclesRemaining != 0 && pipeline.memoryPhaseInst == 0) return;
-
-
-    if (pipeline.executeCyclesRemaining == 0) {
-        pipeline.memoryPhaseInst = pipeline.executePhaseInst;
-        pipeline.executePhaseInst = 0;
-
-        //We don't use decoded parts because next instruction is decoded and we lose the values of current instruction
-        if (((pipeline.memoryPhaseInst >> 28) & 0xF) == 10)
-            temporaryExecuteResult = mainMemory[temporaryExecuteResult];
-        if (((pipeline.memoryPhaseInst >> 28) & 0xF) == 11){
-            mainMemory[temporaryExecuteResult] = registers[temporaryStoreSource]; //not entirely correct, performs WB in memory stage
-            // MARK: memory print
-            printf("MEM PHASE: memory address '%d' written with value '0x%08X', decimal '%d'\n", temporaryExecuteResult, mainMemory[temporaryExecuteResult], mainMemory[temporaryExecuteResult]);
-        }
-    }else {
-        pipeline.memoryPhaseInst = 0;
+    if (batchMode && (saveCheckpointPath != NULL || restoreCheckpointPath != NULL)) {
+        printf("Checkpoints are for a single program, not --batch\n");
+        return 1;
     }
 
-
-}
-
-
-void writeback() {
-    //printf("WB PHASE: register number '%d' written with value '0x%08X', decimal '%d'\n", temporaryExecuteResult, mainMemory[temporaryExecuteResult], mainMemory[temporaryExecuteResult]);
-
-    if (pipeline.writebackPhaseInst == 0 && pipeline.memoryPhaseInst == 0) return;
-
-    if (pipeline.memoryPhaseInst != 0) {
-        pipeline.writebackPhaseInst = pipeline.memoryPhaseInst;
-
-        if (((pipeline.writebackPhaseInst >> 28 ) & 0xF) != 10 && ((pipeline.writebackPhaseInst >> 28) & 0xF ) != 11 &&
-            ((pipeline.writebackPhaseInst >> 28 ) & 0xF )!= 7 && ((pipeline.writebackPhaseInst >> 28 ) & 0xF ) != 4  && temporaryExecuteDestination != 0) {
-            registers[temporaryExecuteDestination] = temporaryExecuteResult;
-            //MARK: REG print
-            printf("\nWB PHASE: R%d set to %d\n", temporaryExecuteDestination, temporaryExecuteResult);
-        }else if (((pipeline.writebackPhaseInst >> 28) & 0xF ) == 7 )  {
-                programCounter = temporaryExecuteResult;
-                isFlushing = false;
-        }else if (((pipeline.writebackPhaseInst >> 28) & 0xF ) == 4) {
-
-            if (temporaryShouldBranch) {
-                programCounter = temporaryExecuteResult - 2;
-                isFlushing = false;
-
-            }
-
-        } else if (((pipeline.memoryPhaseInst >> 28) & 0xF) == 10){
-            if (temporaryExecuteDestination > 0 && temporaryExecuteDestination < 32)
-            registers[temporaryExecuteDestination] = temporaryExecuteResult;
-        } else if (((pipeline.memoryPhaseInst >> 28) & 0xF) == 11) {
-            //haha lol you thought
-        }
-
-    }else {
-        pipeline.writebackPhaseInst = 0;
-
+    if (instructionWords <= 0 || dataWords < 0 || instructionWords + dataWords > MAX_MEMORY_WORDS) {
+        printf("Memory regions must be positive and fit in 2^32 words: %d instruction words, %lld data words\n", instructionWords, dataWords);
+        return 1;
     }
-    registers[0] = 0;
-}
-
-/* Parsing and Loading Methods */
-
-void parseTextInstruction(){
 
-    char tokens[4][10];
-
-    for(int i = 0; i < lineCount; i++){
-
-        //Get Tokens Here
-
-        int tokenIndex = 0;
-        char* token = strtok(lines[i], " ");
-        while(token != NULL){
-
-            strncpy(tokens[tokenIndex], token, 10);
-            tokenIndex++;
-            token = strtok(NULL, " ");
-        }
-
-        //Convert To Binary Format Here
-
-        char* opcode = tokens[0];
-        int binaryInstruction = 0;
-        int opcodeBin = 0;
-
-        if (strcmp(opcode, "ADD") == 0) {
-            opcodeBin = 0;
-        } else if (strcmp(opcode, "SUB") == 0) {
-            opcodeBin = 1;
-        } else if (strcmp(opcode, "MULI") == 0) {
-            opcodeBin = 2;
-        } else if (strcmp(opcode, "ADDI") == 0) {
-            opcodeBin = 3;
-        } else if (strcmp(opcode, "BNE") == 0) {
-            opcodeBin = 4;
-        } else if (strcmp(opcode, "ANDI") == 0) {
-            opcodeBin = 5;
-        } else if (strcmp(opcode, "ORI") == 0) {
-            opcodeBin = 6;
-        } else if (strcmp(opcode, "J") == 0) {
-            opcodeBin = 7;
-        } else if (strcmp(opcode, "SLL") == 0) {
-            opcodeBin = 8;
-            //TODO: Handle SHAMT
-
-            int shamt = atoi(tokens[3]);
-            binaryInstruction |= shamt;
+    if (batchMode) {
+        struct BatchOptions options = {
+            .functionalMode = functionalMode, .outOfOrderMode = outOfOrderMode, .outOfOrderConfig = outOfOrderConfig,
+            .dispatch = dispatch, .predictor = predictor, .resolveStage = resolveStage, .forwarding = forwarding,
+            .pipelineDepth = pipelineDepth, .memoryPorts = memoryPorts, .issueWidth = issueWidth,
+            .storeBufferEntries = storeBufferEntries, .instructionWords = instructionWords, .dataWords = dataWords,
+            .jobs = jobs, .memoryHierarchy = memoryHierarchy
+        };
+        memcpy(options.unitTimings, unitTimings, sizeof(unitTimings));
+        if (batchListPath != NULL && !readProgramList(batchListPath, &programs, &programCount)) return 1;
+        return runBatch(programs, programCount, &options) == 0 ? 0 : 1;
+    }
+    free(programs);
+
+    struct Cpu cpu;
+    initCpu(&cpu, instructionWords, dataWords);
+    initBranchPredictor(&cpu.predictor, predictor);
+    cpu.resolveStage = resolveStage;
+    cpu.forwarding = forwarding;
+    cpu.pipelineDepth = pipelineDepth;
+    cpu.memoryPorts = memoryPorts;
+    cpu.issueWidth = issueWidth;
+    cpu.storeBufferEntries = storeBufferEntries;
+    cpu.outOfOrderConfig = outOfOrderConfig;
+    memcpy(cpu.unitTimings, unitTimings, sizeof(unitTimings));
+    configureMemoryHierarchy(&cpu, &memoryHierarchy);
+
+    if (benchScaling) {
+        runScalingBenchmark(&cpu);
+        return 0;
+    }
 
-        } else if (strcmp(opcode, "SRL") == 0) {
-            opcodeBin = 9;
-            //TODO: Handle SHAMT
-            int shamt = atoi(tokens[3]);
-            binaryInstruction |= shamt;
+    enum CheckpointEngine engine = functionalMode ? CHECKPOINT_FUNCTIONAL : outOfOrderMode ? CHECKPOINT_OUT_OF_ORDER : CHECKPOINT_PIPELINE;
+    if (restoreCheckpointPath != NULL) {
+        if (!restoreCheckpoint(&cpu, engine, restoreCheckpointPath)) return 1;
+        TRACE_SUMMARY("Resumed from %s at PC %d.\n", restoreCheckpointPath, cpu.programCounter);
+    } else if (!loadProgram(&cpu, filepath)) {
+        return 1;
+    }
+    // Without a checkpoint to save the run goes on to the end
+    if (saveCheckpointPath == NULL) checkpointCycle = checkpointInstructions = 0;
 
+    if (benchDispatch) {
+        runDispatchBenchmark(&cpu, 5);
+        return 0;
+    }
 
-        } else if (strcmp(opcode, "LW") == 0) {
-            opcodeBin = 10;
-        } else if (strcmp(opcode, "SW") == 0) {
-            opcodeBin = 11;
+    if (functionalMode) {
+        long long instructionsRetired = runFunctionalFor(&cpu, dispatch, checkpointInstructions);
+        if (cpu.programCounter >= 0 && cpu.programCounter < cpu.lineCount) {
+            if (!saveCheckpoint(&cpu, engine, saveCheckpointPath)) return 1;
+            TRACE_SUMMARY("Checkpoint saved to %s after %lld instructions.\n", saveCheckpointPath, instructionsRetired);
         } else {
-            opcodeBin = -1;
+            TRACE_SUMMARY("Functional run completed, %lld instructions retired.\n", instructionsRetired);
         }
-
-        binaryInstruction |= opcodeBin  << 28;
-
-        int reg1;
-        int reg2;
-        int reg3;
-        int immediateValue;
-
-        if (opcodeBin == 0 || opcodeBin == 1 || opcodeBin == 8 || opcodeBin == 9) {
-            reg1 = atoi(tokens[1] + 1);
-            reg2 = atoi(tokens[2] + 1);
-
-            reg3 = atoi(tokens[3] + 1);
-            if(opcodeBin == 8 || opcodeBin == 9) reg3 = 0;
-
-            binaryInstruction |= reg1 << 23;
-            binaryInstruction |= reg2 << 18;
-            binaryInstruction |= reg3 << 13;
-
-        } else if (opcodeBin == 7) {
-            binaryInstruction |= atoi(tokens[1]);
+    } else {
+        int cycles;
+        if (outOfOrderMode) {
+            cycles = runOutOfOrderUntil(&cpu, checkpointCycle, checkpointInstructions);
         } else {
-            reg1 = atoi(tokens[1] + 1);
-            reg2 = atoi(tokens[2] + 1);
-            immediateValue = atoi(tokens[3]);
-
-            binaryInstruction |= reg1 << 23;
-            binaryInstruction |= reg2 << 18;
-            binaryInstruction |= immediateValue & 0x3FFFF;
-
+            struct BinaryTraceLayout traceLayout;
+            pipelineTraceLayout(&cpu, &traceLayout);
+            if (traceFilepath != NULL && !openBinaryTrace(traceFilepath, &traceLayout)) return 1;
+            cycles = runPipelineUntil(&cpu, checkpointCycle, checkpointInstructions);
+            closeBinaryTrace();
         }
-        mainMemory[i] = binaryInstruction;
-    }
-}
-
-/* Reads text file and writes lines to array of strings*/
-void readFileToMemory(char* filepath){
-
-    char* textInstructions = readFile(filepath);
-    // printf("%s\n", textInstructions);
-    lineCount = 0;
-
-
-    char* token = strtok(textInstructions, "\n");
-    while(token != NULL && lineCount < MAX_LINES){
-        strncpy(lines[lineCount], token, MAX_INSTRUCTION_TOKENS - 1);
-        lines[lineCount][MAX_INSTRUCTION_TOKENS - 1] = '\0';  // Null-terminate to be safe
-
-        // Remove trailing \r if it exists
-        size_t len = strlen(lines[lineCount]);
-        if (len > 0 && lines[lineCount][len - 1] == '\r') {
-            lines[lineCount][len - 1] = '\0';
-        }
-
-        lines[lineCount][MAX_INSTRUCTION_TOKENS - 1] = '\0';
-        lineCount++;
-        token = strtok(NULL, "\n");
-    }
-
-    strncpy(lines[lineCount], "[END]", MAX_INSTRUCTION_TOKENS - 1);
-
-
-}
-
-void printRInstruction(int instruction);
-void printJInstruction(int instruction);
-void printIInstruction(int instruction);
-char* getInstructionText(int instruction);
-
-void printMainMemory() {
-
-    for (int i = 0; i < MAIN_MEMORY_SIZE; i++) {
-        int opcode = mainMemory[i] >> 28;
-        if (opcode == 0 || opcode == 1 || opcode == 8 || opcode == 9) {
-            printRInstruction(mainMemory[i]);
-        } else if (opcode == 7) {
-            printJInstruction(mainMemory[i]);
-        }else {
-            printIInstruction(mainMemory[i]);
+        if (!(outOfOrderMode ? outOfOrderDone(&cpu) : pipelineDone(&cpu))) {
+            if (!saveCheckpoint(&cpu, engine, saveCheckpointPath)) return 1;
+            TRACE_SUMMARY("Checkpoint saved to %s at cycle %d, %lld instructions retired.\n", saveCheckpointPath, cycles,
+                          cpu.counters.instructionsRetired);
+        } else {
+            TRACE_SUMMARY("Simulation completed in %d cycles.\n", cycles);
         }
+        if ((issueWidth > 1 || outOfOrderMode) && cycles > 0)
+            TRACE_SUMMARY("%d-wide %s: %lld instructions retired, IPC %.3f.\n", issueWidth, outOfOrderMode ? "out-of-order core" : "issue",
+                          cpu.counters.instructionsRetired, (double)cpu.counters.instructionsRetired / cycles);
+        long long resolved = cpu.counters.branches + cpu.counters.jumps;
+        if (resolved > 0)
+            TRACE_SUMMARY("Branch predictor %s: %lld of %lld BNE/J predicted correctly.\n", predictorKindName(predictor),
+                          resolved - cpu.counters.flushesBne - cpu.counters.flushesJump, resolved);
+        if (memoryHierarchy.instructionCache.enabled)
+            TRACE_SUMMARY("I-cache: %lld accesses, hit rate %.2f%%, %.2f MPKI.\n", cacheAccesses(&cpu.counters.instructionCache),
+                          100.0 * cacheHitRate(&cpu.counters.instructionCache), cacheMpki(&cpu.counters, &cpu.counters.instructionCache));
+        if (memoryHierarchy.dataCache.enabled)
+            TRACE_SUMMARY("D-cache: %lld accesses, hit rate %.2f%%, %.2f MPKI.\n", cacheAccesses(&cpu.counters.dataCache),
+                          100.0 * cacheHitRate(&cpu.counters.dataCache), cacheMpki(&cpu.counters, &cpu.counters.dataCache));
+        if (memoryHierarchy.prefetcher.kind != PREFETCH_NONE)
+            TRACE_SUMMARY("Prefetcher %s: %lld lines issued, accuracy %.2f%%, coverage %.2f%%, timeliness %.2f%%.\n",
+                          prefetcherKindName(memoryHierarchy.prefetcher.kind), cpu.counters.prefetch.issued,
+                          100.0 * prefetchAccuracy(&cpu.counters), 100.0 * prefetchCoverage(&cpu.counters),
+                          100.0 * prefetchTimeliness(&cpu.counters));
+        if (memoryHierarchy.l2Cache.enabled)
+            TRACE_SUMMARY("L2 cache: %lld accesses, hit rate %.2f%%, %.2f MPKI.\n", cacheAccesses(&cpu.counters.l2Cache),
+                          100.0 * cacheHitRate(&cpu.counters.l2Cache), cacheMpki(&cpu.counters, &cpu.counters.l2Cache));
+        if (memoryHierarchy.dram.enabled)
+            TRACE_SUMMARY("DRAM: %lld accesses, row hit rate %.2f%%.\n", cpu.counters.dram.reads + cpu.counters.dram.writes,
+                          100.0 * dramRowHitRate(&cpu.counters.dram));
     }
 
-}
-
-void printMainMemoryMinimal(){
-    printf("----------------------------\nMain Memory (non-zero):\n");
-    for (int i = 0; i < MAIN_MEMORY_SIZE; i++){
-        if (mainMemory[i] != 0){
-            if (i < DATA_OFFSET){
-                printf("Index: %d, Value: 0x%08X, Instruction Mnemonic: %s\n",i, mainMemory[i], getInstructionText(mainMemory[i]));
-            } else {
-                printf("Index: %d, Value: %d\n",i, mainMemory[i]);
-            }
-        }
+    if (TRACE_AT(TRACE_LEVEL_SUMMARY)) {
+        printRegisters(&cpu);
+        printMainMemoryMinimal(&cpu);
     }
-}
-
-void printRegisters() {
-
-    printf("----------------------\nRegisters:\n");
-    for (int i =0; i < REGISTER_COUNT; i++) {
-        printf("R%d: %d: ", i, registers[i]);
-        if ((i+1) % 4 != 0) printf(" ");
-        else printf("\n");
+    if (statsFilepath != NULL && !writeCountersReport(&cpu.counters, statsFilepath)) {
+        freeCpu(&cpu);
+        return 1;
     }
-
+    freeCpu(&cpu);
 }
-
-void printRegistersMinimal() {
-
-
-    for (int i =0; i < REGISTER_COUNT; i++) {
-        printf("\033[1;32mR%d: %d ", i, registers[i]);
-        printf(" ");
-        if (i == 15) printf("\n");
-    }
-    printf("\n\033[0m");
-
-}
-
-void printPipeline() {
-    printf("  PC: %d\n", programCounter-1);
-    printf("  \033[1;34mIF:  %s\n", getInstructionText(pipeline.fetchPhaseInst));
-    printf("  ID:  %s\n", getInstructionText(pipeline.decodePhaseInst));
-    printf("  EX:  %s\n", getInstructionText(pipeline.executePhaseInst));
-    printf("  MEM: %s\n", getInstructionText(pipeline.memoryPhaseInst));
-    printf("  WB:  %s\n\033[0m", getInstructionText(pipeline.writebackPhaseInst));
-}
-void printRInstruction(int instruction) {
-    // Extract fields
-    int opcode     = (instruction >> 28) & 0xF;
-    int r1         = (instruction >> 23) & 0x1F;
-    int r2         = (instruction >> 18) & 0x1F;
-    int r3         = (instruction >> 13) & 0x1F;
-    int shamt      = instruction & 0x1FFF;
-    int immediate  = instruction & 0x3FFFF;
-    int address    = instruction & 0xFFFFFFF;
-
-    printf("%d %d %d %d %d\n", opcode, r1, r2, r3, shamt);
-
-}
-
-void printJInstruction(int instruction) {
-    int opcode     = (instruction >> 28) & 0xF;
-    int r1         = (instruction >> 23) & 0x1F;
-    int r2         = (instruction >> 18) & 0x1F;
-    int r3         = (instruction >> 13) & 0x1F;
-    int shamt      = instruction & 0x1FFF;
-    int immediate  = instruction & 0x3FFFF;
-    int address    = instruction & 0xFFFFFFF;
-
-    printf("%d %d \n", opcode, address);
-}
-
-void printIInstruction(int instruction) {
-    int opcode     = (instruction >> 28) & 0xF;
-    int r1         = (instruction >> 23) & 0x1F;
-    int r2         = (instruction >> 18) & 0x1F;
-    int r3         = (instruction >> 13) & 0x1F;
-    int shamt      = instruction & 0x1FFF;
-    int immediate  = instruction & 0x3FFFF;
-    int address    = instruction & 0xFFFFFFF;
-
-    printf("%d %d %d %d \n", opcode, r1, r2, immediate);
-}
-
-char* getInstructionText(int instruction) {
-    static char instructionText[50]; // Static buffer to hold the instruction text
-
-    if (instruction == 0) {
-        strcpy(instructionText, "-");
-        return instructionText;
-    }
-
-    int opcode = ((instruction & 0xF0000000) >> 28) & 0xF;
-    int r1 = (instruction & 0x0F800000) >> 23;
-    int r2 = (instruction & 0x007C0000) >> 18;
-    int r3 = (instruction & 0x0003E000) >> 13;
-    int shamt = (instruction & 0x00001FFF);
-    int imm = (instruction & 0x0003FFFF);
-    if ((imm & 0x20000) >> 17 == 1)
-        imm |= 0xFFFC0000; // Make it negative
-    int address = (instruction & 0x0FFFFFFF);
-
-    switch(opcode) {
-        case 0:  // ADD
-            sprintf(instructionText, "ADD R%d R%d R%d", r1, r2, r3);
-            break;
-        case 1:  // SUB
-            sprintf(instructionText, "SUB R%d R%d R%d", r1, r2, r3);
-            break;
-        case 2:  // MULI
-            sprintf(instructionText, "MULI R%d R%d %d", r1, r2, imm);
-            break;
-        case 3:  // ADDI
-            sprintf(instructionText, "ADDI R%d R%d %d", r1, r2, imm);
-            break;
-        case 4:  // BNE
-            sprintf(instructionText, "BNE R%d R%d %d", r1, r2, imm);
-            break;
-        case 5:  // ANDI
-            sprintf(instructionText, "ANDI R%d R%d %d", r1, r2, imm);
-            break;
-        case 6:  // ORI
-            sprintf(instructionText, "ORI R%d R%d %d", r1, r2, imm);
-            break;
-        case 7:  // J
-            sprintf(instructionText, "J %d", address);
-            break;
-        case 8:  // SLL
-            sprintf(instructionText, "SLL R%d R%d %d", r1, r2, shamt);
-            break;
-        case 9:  // SRL
-            sprintf(instructionText, "SRL R%d R%d %d", r1, r2, shamt);
-            break;
-        case 10: // LW
-            sprintf(instructionText, "LW R%d R%d %d", r1, r2, imm);
-            break;
-        case 11: // SW
-            sprintf(instructionText, "SW R%d R%d %d", r1, r2, imm);
-            break;
-        default:
-            sprintf(instructionText, "UNKNOWN");
-            break;
-    }
-
-    return instructionText;
-}
\ No newline at end of file
@@ -1,33 +1,197 @@
+#include "Cpu.h"
+#include "Pipeline.h"
+#include "OutOfOrder.h"
+#include "Functional.h"
+#include "Trace.h"
+#include "Checkpoint.h"
+#include <inttypes.h>
 #include <stdio.h>
 
-extern char* filepath;
-extern void runPipeline();
-extern void readFileToMemory(char* filepath);
-extern void parseTextInstruction();
-extern void printMainMemory();
-
-void runTest(const char* testFile, const char* description) {
-    printf("\n========================================\n");
-    printf("Running test: %s\n", testFile);
-    printf("Description: %s\n", description);
-    printf("========================================\n");
-    
-    filepath = (char*)testFile;
-    readFileToMemory(filepath);
-    parseTextInstruction();
-    printf("\nStarting pipeline execution for %s...\n", testFile);
-    runPipeline();
-}
-
-// int main() {
-//     // Test data hazards
-//     runTest("test_data_hazards.txt", "Testing data hazards with forwarding");
-//
-//     // Test control hazards
-//     runTest("test_control_hazard.txt", "Testing branch prediction and flushing");
-//
-//     // Test combined hazards
-//     runTest("test_combined_hazards.txt", "Testing combination of data and control hazards");
-//
-//     return 0;
-// }
+/* Runs testFile in the pipeline, or with outOfOrder in the out-of-order core, set up by configure, and
+   checks that it ends in the same registers and memory as the functional mode */
+static bool matchesFunctional(const char* testFile, const char* description, void (*configure)(struct Cpu*), bool outOfOrder) {
+    struct Cpu cpu;
+    uint64_t expected = 0, actual = 0;
+    bool loaded;
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    if ((loaded = loadProgram(&cpu, testFile))) {
+        runFunctional(&cpu, DISPATCH_SWITCH);
+        expected = hashCpuState(&cpu);
+    }
+    if (configure != NULL) configure(&cpu);
+    if (loaded && (loaded = loadProgram(&cpu, testFile))) {
+        if (outOfOrder) runOutOfOrderToCompletion(&cpu);
+        else runPipelineToCompletion(&cpu);
+        actual = hashCpuState(&cpu);
+    }
+    freeCpu(&cpu);
+
+    bool passed = loaded && actual == expected;
+    printf("%s %s: %s (%016" PRIx64 ", functional %016" PRIx64 ")\n", passed ? "PASS" : "FAIL", testFile, description,
+           actual, expected);
+    return passed;
+}
+
+/* Assembles a .word list longer than a statement's token limit and checks the sum the program stores after it */
+static bool sumsWordList(void) {
+    struct Cpu cpu;
+    int total = 0;
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    bool loaded = loadProgram(&cpu, "test_word_list.txt");
+    if (loaded) {
+        runFunctional(&cpu, DISPATCH_SWITCH);
+        total = readMemory(&cpu.memory, (uint32_t)cpu.memory.dataOffset + 10);
+    }
+    freeCpu(&cpu);
+
+    bool passed = loaded && total == 55;
+    printf("%s test_word_list.txt: ten .word values on one line (sum %d, expected 55)\n", passed ? "PASS" : "FAIL", total);
+    return passed;
+}
+
+/* Runs testFile in the pipeline set up by configure and checks that it flushed at most once per BNE/J
+   it retired, as a wrong-path branch resolving ahead of an older one would flush again */
+static bool flushesWithinBranches(const char* testFile, const char* description, void (*configure)(struct Cpu*)) {
+    struct Cpu cpu;
+    long long flushes = 0, resolved = 0;
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    configure(&cpu);
+    bool loaded = loadProgram(&cpu, testFile);
+    if (loaded) {
+        runPipelineToCompletion(&cpu);
+        flushes = cpu.counters.flushesBne + cpu.counters.flushesJump;
+        resolved = cpu.counters.branches + cpu.counters.jumps;
+    }
+    freeCpu(&cpu);
+
+    bool passed = loaded && flushes <= resolved;
+    printf("%s %s: %s (%lld flushes, %lld BNE/J)\n", passed ? "PASS" : "FAIL", testFile, description, flushes, resolved);
+    return passed;
+}
+
+#define CHECKPOINT_TEST_PATH "CASimulatorTests.checkpoint"
+
+/* Runs to completion in the given engine, or with CHECKPOINT_FUNCTIONAL in the functional mode */
+static void runInEngine(struct Cpu* cpu, enum CheckpointEngine engine) {
+    if (engine == CHECKPOINT_FUNCTIONAL) runFunctional(cpu, DISPATCH_SWITCH);
+    else if (engine == CHECKPOINT_OUT_OF_ORDER) runOutOfOrderToCompletion(cpu);
+    else runPipelineToCompletion(cpu);
+}
+
+/* Stops testFile after the given number of cycles, or instructions in the functional mode, saves a
+   checkpoint and restores it into a fresh processor for resumeEngine. The resumed run has to end in the
+   same state as one straight through in resumeEngine, and with an engine checkpoint on the same cycle. */
+static bool resumesFromCheckpoint(const char* testFile, const char* description, enum CheckpointEngine saveEngine,
+                                  enum CheckpointEngine resumeEngine, long long limit) {
+    struct Cpu cpu;
+    uint64_t expected = 0, actual = 0;
+    long long expectedCycles = 0, actualCycles = 0;
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    bool passed = loadProgram(&cpu, testFile);
+    if (passed) {
+        runInEngine(&cpu, resumeEngine);
+        expected = hashCpuState(&cpu);
+        expectedCycles = cpu.counters.cycles;
+        passed = loadProgram(&cpu, testFile);
+    }
+    if (passed) {
+        if (saveEngine == CHECKPOINT_FUNCTIONAL) runFunctionalFor(&cpu, DISPATCH_SWITCH, limit);
+        else if (saveEngine == CHECKPOINT_OUT_OF_ORDER) runOutOfOrderUntil(&cpu, limit, 0);
+        else runPipelineUntil(&cpu, limit, 0);
+        passed = saveCheckpoint(&cpu, saveEngine, CHECKPOINT_TEST_PATH);
+    }
+    freeCpu(&cpu);
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    if (passed && (passed = restoreCheckpoint(&cpu, resumeEngine, CHECKPOINT_TEST_PATH))) {
+        runInEngine(&cpu, resumeEngine);
+        actual = hashCpuState(&cpu);
+        actualCycles = cpu.counters.cycles;
+    }
+    freeCpu(&cpu);
+    remove(CHECKPOINT_TEST_PATH);
+
+    passed = passed && actual == expected && (saveEngine == CHECKPOINT_FUNCTIONAL || actualCycles == expectedCycles);
+    printf("%s %s: %s (%016" PRIx64 " in %lld cycles, straight through %016" PRIx64 " in %lld)\n", passed ? "PASS" : "FAIL",
+           testFile, description, actual, actualCycles, expected, expectedCycles);
+    return passed;
+}
+
+/* A checkpoint whose lineCount runs past the instruction region is rejected rather than predecoded */
+static bool rejectsCorruptCheckpoint(void) {
+    struct Cpu cpu;
+    int32_t lineCount = DEFAULT_INSTRUCTION_WORDS + 1;
+
+    initCpu(&cpu, DEFAULT_INSTRUCTION_WORDS, DEFAULT_DATA_WORDS);
+    bool saved = loadProgram(&cpu, "test_combined_hazards.txt") && saveCheckpoint(&cpu, CHECKPOINT_FUNCTIONAL, CHECKPOINT_TEST_PATH);
+    FILE* file = saved ? fopen(CHECKPOINT_TEST_PATH, "r+b") : NULL;
+    // lineCount follows the header, written field by field, and the program counter
+    bool corrupted = file != NULL && fseek(file, 4 + 4 + 4 + 8 + 8 + 4 + 4, SEEK_SET) == 0 &&
+                     fwrite(&lineCount, sizeof(lineCount), 1, file) == 1;
+    if (file != NULL) fclose(file);
+    bool passed = corrupted && !restoreCheckpoint(&cpu, CHECKPOINT_PIPELINE, CHECKPOINT_TEST_PATH);
+    freeCpu(&cpu);
+    remove(CHECKPOINT_TEST_PATH);
+
+    printf("%s checkpoint with lineCount past the instruction region is rejected\n", passed ? "PASS" : "FAIL");
+    return passed;
+}
+
+static void wideIssue(struct Cpu* cpu) {
+    cpu->issueWidth = 4;
+}
+
+static void wideIssueSplitPorts(struct Cpu* cpu) {
+    cpu->issueWidth = 4;
+    cpu->memoryPorts = MEMORY_SPLIT_PORTS;
+}
+
+static void wideIssueStoreBuffer(struct Cpu* cpu) {
+    cpu->issueWidth = 4;
+    cpu->memoryPorts = MEMORY_SPLIT_PORTS;
+    cpu->storeBufferEntries = 4;
+}
+
+static void resolveInDecodeNotTaken(struct Cpu* cpu) {
+    initBranchPredictor(&cpu->predictor, PREDICTOR_NOT_TAKEN);
+    cpu->resolveStage = RESOLVE_IN_DECODE;
+    cpu->memoryPorts = MEMORY_SPLIT_PORTS;
+}
+
+static void resolveInDecodeNotTakenWide(struct Cpu* cpu) {
+    resolveInDecodeNotTaken(cpu);
+    cpu->issueWidth = 4;
+}
+
+int main() {
+    int failed = 0;
+
+    traceLevel = TRACE_LEVEL_NONE;
+    failed += !matchesFunctional("test_data_hazards.txt", "data hazards with forwarding", NULL, false);
+    failed += !matchesFunctional("test_control_hazard.txt", "branch prediction and flushing", NULL, false);
+    failed += !matchesFunctional("test_combined_hazards.txt", "data and control hazards combined", NULL, false);
+    // SW R5 R1 0 overwrites the ORI at PC 10 after a 4-wide fetch has already fetched it
+    failed += !matchesFunctional("programInstructions.txt", "self-modifying store, 4-wide", wideIssue, false);
+    failed += !matchesFunctional("programInstructions.txt", "self-modifying store, 4-wide, split ports", wideIssueSplitPorts, false);
+    failed += !matchesFunctional("programInstructions.txt", "self-modifying store, 4-wide, store buffer", wideIssueStoreBuffer, false);
+    failed += !matchesFunctional("test_out_of_bounds.txt", "out-of-bounds LW/SW leave the register, pipeline", NULL, false);
+    failed += !matchesFunctional("test_out_of_bounds.txt", "out-of-bounds LW/SW leave the register, out-of-order", NULL, true);
+    failed += !matchesFunctional("test_out_of_bounds.txt", "out-of-bounds LW/SW leave the register, out-of-order 4-wide", wideIssue, true);
+    failed += !sumsWordList();
+    failed += !matchesFunctional("test_word_list.txt", "ten .word values on one line", NULL, false);
+    failed += !flushesWithinBranches("test_resolve_in_decode.txt", "BNE in ID behind one resolving in EX", resolveInDecodeNotTaken);
+    failed += !flushesWithinBranches("test_resolve_in_decode.txt", "BNE in ID behind one resolving in EX, 4-wide", resolveInDecodeNotTakenWide);
+    failed += !matchesFunctional("test_resolve_in_decode.txt", "BNE in ID behind one resolving in EX", resolveInDecodeNotTaken, false);
+    failed += !resumesFromCheckpoint("test_combined_hazards.txt", "pipeline checkpoint at cycle 20", CHECKPOINT_PIPELINE,
+                                     CHECKPOINT_PIPELINE, 20);
+    failed += !resumesFromCheckpoint("test_combined_hazards.txt", "out-of-order checkpoint at cycle 12", CHECKPOINT_OUT_OF_ORDER,
+                                     CHECKPOINT_OUT_OF_ORDER, 12);
+    failed += !resumesFromCheckpoint("test_combined_hazards.txt", "functional checkpoint after 10 instructions, resumed in the pipeline",
+                                     CHECKPOINT_FUNCTIONAL, CHECKPOINT_PIPELINE, 10);
+    failed += !rejectsCorruptCheckpoint();
+    return failed > 0;
+}